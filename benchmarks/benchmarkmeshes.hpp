@@ -0,0 +1,57 @@
+#ifndef BENCHMARKMESHES_HPP
+#define BENCHMARKMESHES_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+// Meshes and timing shared by the benchmarks
+
+struct BenchmarkMesh {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvs;
+    std::vector<unsigned int> indices;
+};
+
+// A closed torus of 2 * rings * sides triangles
+inline BenchmarkMesh makeTorus(unsigned int rings, unsigned int sides) {
+    BenchmarkMesh mesh;
+    const float twoPi = glm::two_pi<float>();
+    for (unsigned int r = 0; r < rings; r++) {
+        for (unsigned int s = 0; s < sides; s++) {
+            float u = float(r) / rings, v = float(s) / sides;
+            float a = u * twoPi, b = v * twoPi;
+            float radius = 1.0f + 0.3f * std::cos(b);
+            mesh.positions.push_back(glm::vec3(radius * std::cos(a), radius * std::sin(a), 0.3f * std::sin(b)));
+            mesh.uvs.push_back(glm::vec2(u, v));
+        }
+    }
+    for (unsigned int r = 0; r < rings; r++) {
+        for (unsigned int s = 0; s < sides; s++) {
+            unsigned int a = r * sides + s, b = r * sides + (s + 1) % sides;
+            unsigned int c = ((r + 1) % rings) * sides + s, d = ((r + 1) % rings) * sides + (s + 1) % sides;
+            unsigned int quad[6] = { a, c, d, a, d, b };
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    return mesh;
+}
+
+// Shortest of a few runs of 'body', in milliseconds; small inputs run more often
+template <typename Body>
+double bestOf(size_t triangles, Body body) {
+    int runs = triangles < 100000 ? 10 : triangles < 2000000 ? 3 : 1;
+    double best = HUGE_VAL;
+    for (int i = 0; i < runs; i++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        body();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+#endif
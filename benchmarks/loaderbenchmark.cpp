@@ -0,0 +1,77 @@
+// Compares loadOBJ's default mode with countRecordsFirst on one file:
+// parse and index time, and the process's peak resident set size.
+//
+//   loaderbenchmark [file.obj] [default|count-first]
+//
+// Peak RSS is a high-water mark for the whole process, so without a mode the
+// benchmark runs itself once per mode and each number covers one load only.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "common/objloader.hpp"
+
+namespace {
+
+const char *defaultPath = "source/low_poly_head.obj";
+
+double megabytes(size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+int runMode(const char *path, bool countRecordsFirst) {
+    size_t baseRSS = getPeakRSS();
+
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<unsigned int> indices;
+    OBJLoadStats stats;
+    OBJLoadOptions options;
+    options.countRecordsFirst = countRecordsFirst;
+    options.stats = &stats;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (!loadOBJ(path, vertices, uvs, normals, indices, options))
+        return 1;
+    double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t meshBytes = vertices.size() * sizeof(glm::vec3) + uvs.size() * sizeof(glm::vec2) +
+                       normals.size() * sizeof(glm::vec3) + indices.size() * sizeof(unsigned int);
+    printf("%-11s %9zu triangles %9zu vertices  parse %8.1f ms  index %8.1f ms  total %8.1f ms  "
+           "peak RSS %8.1f MB (%.1f MB before, mesh %.1f MB)\n",
+           countRecordsFirst ? "count-first" : "default", stats.triangles, vertices.size(),
+           stats.parseSeconds * 1000.0, stats.indexSeconds * 1000.0, total * 1000.0,
+           megabytes(stats.peakRSSBytes), megabytes(baseRSS), megabytes(meshBytes));
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : defaultPath;
+    if (argc > 2) {
+        if (strcmp(argv[2], "default") == 0)
+            return runMode(path, false);
+        if (strcmp(argv[2], "count-first") == 0)
+            return runMode(path, true);
+        fprintf(stderr, "usage: %s [file.obj] [default|count-first]\n", argv[0]);
+        return 2;
+    }
+
+    // One process per mode so neither inherits the other's peak
+    const char *modes[] = { "default", "count-first" };
+    int result = 0;
+    for (const char *mode : modes) {
+        std::string command = std::string("\"") + argv[0] + "\" \"" + path + "\" " + mode;
+        fflush(stdout);
+        if (system(command.c_str()) != 0)
+            result = 1;
+    }
+    return result;
+}
@@ -0,0 +1,91 @@
+// Compares the two vertex normal implementations on the head mesh at Loop
+// level 4 and on a generated torus of about a million triangles:
+//
+//   scatter   computeVertexNormalsScatter, serial
+//   gather    computeVertexNormalsGather with the corner table built beforehand
+//   +table    the same, including buildVertexCornerTable
+//
+// along with the largest difference between their normals.
+//
+//   normalsbenchmark [file.obj]
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "common/objloader.hpp"
+#include "common/meshtopology.hpp"
+#include "common/loopsubdivision.hpp"
+#include "common/vertexnormals.hpp"
+#include "common/threadpool.hpp"
+#include "benchmarkmeshes.hpp"
+
+namespace {
+
+const char *defaultPath = "source/low_poly_head.obj";
+const int headLevel = 4;
+
+const char *weightingName(NormalWeighting weighting) {
+    switch (weighting) {
+    case NormalWeighting::Uniform: return "uniform";
+    case NormalWeighting::Area: return "area";
+    case NormalWeighting::Angle: return "angle";
+    }
+    return "";
+}
+
+void run(const char *name, const BenchmarkMesh &mesh) {
+    size_t triangles = mesh.indices.size() / 3;
+    printf("\n%s: %zu triangles, %zu vertices\n", name, triangles, mesh.positions.size());
+    printf("weighting   scatter    gather    +table   max difference\n");
+
+    VertexCorners corners;
+    buildVertexCornerTable(mesh.indices, mesh.positions.size(), corners);
+    const NormalWeighting weightings[] = { NormalWeighting::Uniform, NormalWeighting::Area, NormalWeighting::Angle };
+    for (NormalWeighting weighting : weightings) {
+        std::vector<glm::vec3> scattered, gathered;
+        double scatterMs = bestOf(triangles, [&]() {
+            computeVertexNormalsScatter(mesh.positions, mesh.indices, scattered, weighting);
+        });
+        double gatherMs = bestOf(triangles, [&]() {
+            computeVertexNormalsGather(mesh.positions, mesh.indices, corners, gathered, weighting);
+        });
+        double tableMs = bestOf(triangles, [&]() {
+            VertexCorners table;
+            buildVertexCornerTable(mesh.indices, mesh.positions.size(), table);
+            computeVertexNormalsGather(mesh.positions, mesh.indices, table, gathered, weighting);
+        });
+
+        float difference = 0.0f;
+        for (size_t v = 0; v < scattered.size(); v++)
+            difference = std::max(difference, glm::length(scattered[v] - gathered[v]));
+        printf("%-9s %9.2f %9.2f %9.2f   %g\n", weightingName(weighting), scatterMs, gatherMs, tableMs, difference);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : defaultPath;
+    printf("Thread pool: %u workers\n", ThreadPool::shared().size());
+
+    BenchmarkMesh head;
+    std::vector<glm::vec3> normals;
+    if (!loadOBJ(path, head.positions, head.uvs, normals, head.indices))
+        return 1;
+    for (int level = 0; level < headLevel; level++) {
+        LoopLevel next;
+        buildLoopLevel(head.indices, head.positions.size(), next);
+        std::vector<glm::vec3> refined;
+        applyStencils(next.stencils, head.positions, refined);
+        head.positions = std::move(refined);
+        head.indices = std::move(next.indices);
+    }
+    char label[256];
+    snprintf(label, sizeof(label), "%s at level %d", path, headLevel);
+    run(label, head);
+    run("torus", makeTorus(1000, 500));
+    return 0;
+}
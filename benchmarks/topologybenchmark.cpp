@@ -0,0 +1,123 @@
+// Times the flat adjacency tables and Loop subdivision levels 1-4, on the head
+// mesh and on a generated torus of about a million triangles:
+//
+//   maps      the std::map/std::set adjacency applyLoopSubdivision used to build
+//   topology  buildMeshTopology on the same triangles
+//   level     buildLoopLevel (topology, stencils and cache ordering)
+//   apply     applyStencils for positions and UVs
+//
+//   topologybenchmark [file.obj] [max output triangles]
+//
+// Levels whose output would exceed the triangle limit (default 20M) are
+// skipped, and the map adjacency is only built for inputs up to 2M triangles.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "common/objloader.hpp"
+#include "common/meshtopology.hpp"
+#include "common/loopsubdivision.hpp"
+#include "benchmarkmeshes.hpp"
+
+namespace {
+
+const char *defaultPath = "source/low_poly_head.obj";
+const size_t defaultMaxTriangles = 20000000;
+const size_t maxReferenceTriangles = 2000000;
+
+// The undirected edge key the old adjacency maps used
+struct Edge {
+    unsigned int v1, v2;
+    bool operator<(const Edge &other) const {
+        unsigned int min1 = std::min(v1, v2), max1 = std::max(v1, v2);
+        unsigned int min2 = std::min(other.v1, other.v2), max2 = std::max(other.v1, other.v2);
+        if (min1 != min2)
+            return min1 < min2;
+        return max1 < max2;
+    }
+};
+
+// The adjacency applyLoopSubdivision built before the CSR tables. Returns the edge count.
+size_t buildMapAdjacency(const std::vector<unsigned int> &indices) {
+    std::map<Edge, std::vector<unsigned int>> edgeOppositeVertices;
+    std::map<Edge, int> edgeFaceCount;
+    std::map<unsigned int, std::set<unsigned int>> vertexNeighbors;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        unsigned int v[3] = { indices[i], indices[i + 1], indices[i + 2] };
+        for (int j = 0; j < 3; ++j) {
+            Edge edge = { v[j], v[(j + 1) % 3] };
+            edgeFaceCount[edge]++;
+            edgeOppositeVertices[edge].push_back(v[(j + 2) % 3]);
+            vertexNeighbors[v[j]].insert(v[(j + 1) % 3]);
+            vertexNeighbors[v[(j + 1) % 3]].insert(v[j]);
+        }
+    }
+    std::set<Edge> boundaryEdges;
+    std::set<unsigned int> boundaryVertices;
+    for (const auto &pair : edgeFaceCount) {
+        if (pair.second == 1) {
+            boundaryEdges.insert(pair.first);
+            boundaryVertices.insert(pair.first.v1);
+            boundaryVertices.insert(pair.first.v2);
+        }
+    }
+    return edgeFaceCount.size();
+}
+
+void run(const char *name, BenchmarkMesh mesh, size_t maxTriangles) {
+    printf("\n%s: %zu triangles, %zu vertices\n", name, mesh.indices.size() / 3, mesh.positions.size());
+    printf("level   in tris  out tris      maps  topology  speedup     level     apply\n");
+    size_t triangles = mesh.indices.size() / 3;
+    for (int level = 1; level <= 4; level++, triangles *= 4) {
+        if (triangles * 4 > maxTriangles) {
+            printf("%5d %9zu %9zu   skipped (over the %zu triangle limit)\n", level, triangles, triangles * 4, maxTriangles);
+            continue;
+        }
+
+        char maps[16] = "        -", speedup[16] = "      -";
+        MeshTopology topology;
+        double topologyMs = bestOf(triangles, [&]() { buildMeshTopology(mesh.indices, mesh.positions.size(), topology); });
+        if (triangles <= maxReferenceTriangles) {
+            size_t edges = 0;
+            double mapsMs = bestOf(triangles, [&]() { edges = buildMapAdjacency(mesh.indices); });
+            if (edges != topology.edgeCount())
+                printf("edge counts differ: maps %zu, topology %zu\n", edges, topology.edgeCount());
+            snprintf(maps, sizeof(maps), "%9.1f", mapsMs);
+            snprintf(speedup, sizeof(speedup), "%6.1fx", mapsMs / topologyMs);
+        }
+
+        LoopLevel next;
+        double levelMs = bestOf(triangles, [&]() { next = LoopLevel(); buildLoopLevel(mesh.indices, mesh.positions.size(), next); });
+        BenchmarkMesh refined;
+        double applyMs = bestOf(triangles, [&]() {
+            applyStencils(next.stencils, mesh.positions, refined.positions);
+            applyStencils(next.stencils, mesh.uvs, refined.uvs);
+        });
+        printf("%5d %9zu %9zu %s %9.1f %s %9.1f %9.1f\n", level, triangles, next.indices.size() / 3,
+               maps, topologyMs, speedup, levelMs, applyMs);
+
+        refined.indices = std::move(next.indices);
+        mesh = std::move(refined);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : defaultPath;
+    size_t maxTriangles = argc > 2 ? strtoull(argv[2], nullptr, 10) : defaultMaxTriangles;
+
+    BenchmarkMesh head;
+    std::vector<glm::vec3> normals;
+    if (!loadOBJ(path, head.positions, head.uvs, normals, head.indices))
+        return 1;
+    run(path, std::move(head), maxTriangles);
+    run("torus", makeTorus(1000, 500), maxTriangles);
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "assetregistry.hpp"
+#include "meshcache.hpp"
+
+namespace {
+
+bool readText(const char *path, std::string &text) {
+    std::ifstream stream(path, std::ios::in | std::ios::binary);
+    if (!stream.is_open())
+        return false;
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+    text = buffer.str();
+    return true;
+}
+
+// Drops map entries whose asset is gone
+template <typename Map>
+void sweep(Map &map) {
+    for (auto it = map.begin(); it != map.end();) {
+        if (it->second.expired())
+            it = map.erase(it);
+        else
+            ++it;
+    }
+}
+
+} // namespace
+
+AssetRegistry &AssetRegistry::shared() {
+    static AssetRegistry registry;
+    return registry;
+}
+
+std::string AssetRegistry::canonicalPath(const char *path) {
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(std::filesystem::path(path), error);
+    return error ? std::string(path) : canonical.generic_string();
+}
+
+void AssetRegistry::defer(std::function<void()> release) {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pending.push_back(std::move(release));
+}
+
+void AssetRegistry::collect() {
+    std::vector<std::function<void()>> releases;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        releases.swap(pending);
+    }
+    for (std::function<void()> &release : releases)
+        release();
+    if (!releases.empty()) {
+        sweep(programsByPath);
+        sweep(programsByHash);
+        sweep(texturesByPath);
+        sweep(texturesByHash);
+        sweep(geometries);
+    }
+}
+
+size_t AssetRegistry::pendingReleases() const {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    return pending.size();
+}
+
+std::shared_ptr<ShaderProgram> AssetRegistry::program(const char *vertexPath, const char *fragmentPath) {
+    std::string pathKey = canonicalPath(vertexPath) + '\0' + canonicalPath(fragmentPath);
+    auto byPath = programsByPath.find(pathKey);
+    if (byPath != programsByPath.end()) {
+        if (std::shared_ptr<ShaderProgram> existing = byPath->second.lock())
+            return existing;
+    }
+
+    // Not loaded from these paths: the same sources may be under others
+    std::string vertexSource, fragmentSource;
+    bool readable = readText(vertexPath, vertexSource) && readText(fragmentPath, fragmentSource);
+    std::string sources = vertexSource + '\0' + fragmentSource;
+    uint64_t hash = hashBytes(sources.data(), sources.size());
+    if (readable) {
+        auto byHash = programsByHash.find(hash);
+        if (byHash != programsByHash.end() && byHash->second.sources == sources) {
+            if (std::shared_ptr<ShaderProgram> existing = byHash->second.program.lock()) {
+                programsByPath[pathKey] = existing;
+                return existing;
+            }
+        }
+    }
+
+    std::shared_ptr<ShaderProgram> created(new ShaderProgram(), [this](ShaderProgram *program) {
+        defer([program]() { delete program; });
+    });
+    if (!created->load(vertexPath, fragmentPath))
+        return nullptr;
+    programsByPath[pathKey] = created;
+    if (readable) {
+        // A live program with colliding sources keeps the hash; this one is found by path only
+        ProgramEntry &entry = programsByHash[hash];
+        if (entry.expired())
+            entry = { created, sources };
+    }
+    return created;
+}
+
+std::shared_ptr<TextureAsset> AssetRegistry::findTexture(const std::string &path) const {
+    auto it = texturesByPath.find(path);
+    return (it != texturesByPath.end()) ? it->second.lock() : nullptr;
+}
+
+std::shared_ptr<TextureAsset> AssetRegistry::findTexture(uint64_t contentHash) const {
+    auto it = texturesByHash.find(contentHash);
+    return (it != texturesByHash.end()) ? it->second.lock() : nullptr;
+}
+
+std::shared_ptr<TextureAsset> AssetRegistry::createTexture(const std::string &path, uint64_t contentHash) {
+    std::shared_ptr<TextureAsset> created(new TextureAsset(), [this](TextureAsset *texture) {
+        defer([texture]() {
+            glDeleteTextures(1, &texture->texture);
+            delete texture;
+        });
+    });
+    glGenTextures(1, &created->texture);
+    created->contentHash = contentHash;
+    if (!findTexture(contentHash)) {
+        created->registered = true;
+        texturesByHash[contentHash] = created;
+        texturesByPath[path] = created;
+    }
+    return created;
+}
+
+std::shared_ptr<GeometryAsset> AssetRegistry::findGeometry(uint64_t contentHash, uint64_t checkHash, size_t vertexCount,
+                                                           size_t indexCount) const {
+    auto it = geometries.find(contentHash);
+    if (it == geometries.end())
+        return nullptr;
+    std::shared_ptr<GeometryAsset> geometry = it->second.lock();
+    if (geometry && (geometry->checkHash != checkHash || geometry->vertexCount != vertexCount || geometry->indexCount != indexCount))
+        return nullptr; // A hash collision
+    return geometry;
+}
+
+std::shared_ptr<GeometryAsset> AssetRegistry::createPrivateGeometry(size_t vertexCount, size_t indexCount, VertexFormat format) {
+    std::shared_ptr<GeometryAsset> created(new GeometryAsset(), [this](GeometryAsset *geometry) {
+        defer([geometry]() {
+            GeometryArena::shared().release(geometry->range);
+            delete geometry;
+        });
+    });
+    created->range = GeometryArena::shared().allocate(vertexCount, indexCount, format);
+    created->vertexCount = vertexCount;
+    created->indexCount = indexCount;
+    return created;
+}
+
+std::shared_ptr<GeometryAsset> AssetRegistry::createGeometry(uint64_t contentHash, uint64_t checkHash, size_t vertexCount,
+                                                             size_t indexCount, VertexFormat format) {
+    std::shared_ptr<GeometryAsset> created = createPrivateGeometry(vertexCount, indexCount, format);
+    created->contentHash = contentHash;
+    created->checkHash = checkHash;
+    auto it = geometries.find(contentHash);
+    if (it == geometries.end() || it->second.expired()) {
+        created->registered = true;
+        geometries[contentHash] = created;
+    }
+    return created;
+}
+
+void AssetRegistry::unregister(GeometryAsset &geometry) {
+    if (!geometry.registered)
+        return;
+    auto it = geometries.find(geometry.contentHash);
+    if (it != geometries.end() && it->second.lock().get() == &geometry)
+        geometries.erase(it);
+    geometry.registered = false;
+}
@@ -0,0 +1,112 @@
+#ifndef ASSETREGISTRY_HPP
+#define ASSETREGISTRY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "shaderprogram.hpp"
+#include "geometryarena.hpp"
+
+// A texture object that several meshes may sample.
+struct TextureAsset {
+    GLuint texture = 0;
+    bool ready = false;      // All levels uploaded; until then only its creator may use it
+    bool registered = false; // Found by later requests
+    uint64_t contentHash = 0;
+};
+
+// A mesh in the GeometryArena that several objects may draw from
+struct GeometryAsset {
+    ArenaRange range;
+    size_t vertexCount = 0, indexCount = 0; // Checked on a hash match
+    bool ready = false;
+    bool registered = false;
+    uint64_t contentHash = 0;
+    uint64_t checkHash = 0; // A second, independent hash of the same arrays, checked on a hash match
+};
+
+// Reference-counted GL assets, shared between identical requests. Shader
+// programs are keyed by the content of their two source files; textures by
+// canonical file path (so a repeat load can skip decoding) and by the hash of
+// the file's bytes; geometry by the hash of its vertex and index arrays, with
+// a second hash of them ruling out collisions.
+// The registry only keeps weak references: an asset lives as long as some
+// object holds it. When the last reference goes, its GL objects are not
+// deleted on the spot but queued until collect(), which the frame loop calls
+// at a point where no draw can still be using them.
+//
+// GL thread only, except that the last reference may be dropped anywhere.
+class AssetRegistry {
+public:
+    static AssetRegistry &shared();
+
+    // The program built from these files, compiling it on the first request.
+    // A live program is found by the canonical paths without touching the
+    // files; otherwise the sources are read and matched by content (so a
+    // copy under another path is shared too). Null if it does not link.
+    std::shared_ptr<ShaderProgram> program(const char *vertexPath, const char *fragmentPath);
+
+    // Registered textures, or null. The path lookup takes a canonical path.
+    std::shared_ptr<TextureAsset> findTexture(const std::string &path) const;
+    std::shared_ptr<TextureAsset> findTexture(uint64_t contentHash) const;
+
+    // A new texture name to fill in, registered under both keys unless a live
+    // texture already has the hash (then it stays private). Set 'ready' once
+    // uploaded.
+    std::shared_ptr<TextureAsset> createTexture(const std::string &path, uint64_t contentHash);
+
+    // Registered geometry, or null. It must match both hashes and the counts.
+    std::shared_ptr<GeometryAsset> findGeometry(uint64_t contentHash, uint64_t checkHash, size_t vertexCount, size_t indexCount) const;
+
+    // New arena space, registered like createTexture. The hashes should
+    // cover the format too.
+    std::shared_ptr<GeometryAsset> createGeometry(uint64_t contentHash, uint64_t checkHash, size_t vertexCount, size_t indexCount,
+                                                  VertexFormat format = VertexFormat::Separate);
+
+    // New arena space that is never found by others (e.g. for a mesh that is
+    // about to be edited).
+    std::shared_ptr<GeometryAsset> createPrivateGeometry(size_t vertexCount, size_t indexCount,
+                                                         VertexFormat format = VertexFormat::Separate);
+
+    // Stops handing 'geometry' out; its current holders keep it.
+    void unregister(GeometryAsset &geometry);
+
+    // Deletes the GL objects of every asset released since the last call.
+    void collect();
+
+    size_t pendingReleases() const;
+
+    // Absolute path with '.', '..' and symlinks resolved, or 'path' unchanged if that fails.
+    static std::string canonicalPath(const char *path);
+
+private:
+    AssetRegistry() {}
+
+    void defer(std::function<void()> release);
+
+    // A program with the sources it was built from, to rule out hash collisions
+    struct ProgramEntry {
+        std::weak_ptr<ShaderProgram> program;
+        std::string sources;
+        bool expired() const { return program.expired(); }
+    };
+
+    std::unordered_map<std::string, std::weak_ptr<ShaderProgram>> programsByPath;
+    std::unordered_map<uint64_t, ProgramEntry> programsByHash;
+    std::unordered_map<std::string, std::weak_ptr<TextureAsset>> texturesByPath;
+    std::unordered_map<uint64_t, std::weak_ptr<TextureAsset>> texturesByHash;
+    std::unordered_map<uint64_t, std::weak_ptr<GeometryAsset>> geometries;
+
+    mutable std::mutex pendingMutex;
+    std::vector<std::function<void()>> pending;
+};
+
+#endif
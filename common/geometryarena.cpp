@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
+#include "geometryarena.hpp"
+
+namespace {
+
+// The float streams of a Separate block, set up on its bound VAO
+void setupSeparateStreams(GeometryArena::Block &b, unsigned int vertexCapacity) {
+    GLuint buffers[3];
+    glGenBuffers(3, buffers);
+    b.positions = buffers[0];
+    b.uvs = buffers[1];
+    b.normals = buffers[2];
+
+    PositionStream::bind(b.positions);
+    glBufferData(GL_ARRAY_BUFFER, size_t(vertexCapacity) * PositionStream::stride, nullptr, GL_STATIC_DRAW);
+    UvStream::bind(b.uvs);
+    glBufferData(GL_ARRAY_BUFFER, size_t(vertexCapacity) * UvStream::stride, nullptr, GL_STATIC_DRAW);
+    NormalStream::bind(b.normals);
+    glBufferData(GL_ARRAY_BUFFER, size_t(vertexCapacity) * NormalStream::stride, nullptr, GL_STATIC_DRAW);
+}
+
+} // namespace
+
+FreeList::FreeList(unsigned int capacity) : total(capacity), available(capacity) {
+    if (capacity > 0)
+        spans[0] = capacity;
+}
+
+bool FreeList::allocate(unsigned int size, unsigned int &offset) {
+    if (size == 0) {
+        offset = 0;
+        return true;
+    }
+    for (auto it = spans.begin(); it != spans.end(); ++it) {
+        if (it->second < size)
+            continue;
+        offset = it->first;
+        unsigned int rest = it->second - size;
+        spans.erase(it);
+        if (rest > 0)
+            spans[offset + size] = rest;
+        available -= size;
+        return true;
+    }
+    return false;
+}
+
+void FreeList::release(unsigned int offset, unsigned int size) {
+    if (size == 0)
+        return;
+    available += size;
+    auto next = spans.lower_bound(offset);
+    if (next != spans.end() && offset + size == next->first) {
+        size += next->second;
+        next = spans.erase(next);
+    }
+    if (next != spans.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            previous->second += size;
+            return;
+        }
+    }
+    spans[offset] = size;
+}
+
+GeometryArena &GeometryArena::shared() {
+    static GeometryArena arena;
+    return arena;
+}
+
+int GeometryArena::addBlock(VertexFormat format, unsigned int vertexCapacity, unsigned int indexCapacity) {
+    Block b;
+    b.format = format;
+    b.vertexSpace = FreeList(vertexCapacity);
+    b.indexSpace = FreeList(indexCapacity);
+
+    // Set up a VAO without disturbing the caller's
+    GLint previous = 0;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous);
+    glGenVertexArrays(1, &b.vertexArray);
+    glBindVertexArray(b.vertexArray);
+
+    if (format == VertexFormat::Packed) {
+        glGenBuffers(1, &b.vertices);
+        PackedLayout::bind(b.vertices);
+        glBufferData(GL_ARRAY_BUFFER, size_t(vertexCapacity) * PackedLayout::stride, nullptr, GL_STATIC_DRAW);
+    } else {
+        setupSeparateStreams(b, vertexCapacity);
+    }
+
+    glGenBuffers(1, &b.indices);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, b.indices);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, size_t(indexCapacity) * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+
+    glBindVertexArray(previous);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    printf("Geometry arena block %zu: %u %s vertices, %u indices\n", blocks.size(), vertexCapacity,
+           (format == VertexFormat::Packed) ? "packed" : "separate", indexCapacity);
+    blocks.push_back(b);
+    return static_cast<int>(blocks.size() - 1);
+}
+
+ArenaRange GeometryArena::allocate(size_t vertexCount, size_t indexCount, VertexFormat format) {
+    ArenaRange range;
+    range.vertexCount = static_cast<unsigned int>(vertexCount);
+    range.indexCount = static_cast<unsigned int>(indexCount);
+    for (size_t i = 0; i < blocks.size() && !range.valid(); i++) {
+        Block &b = blocks[i];
+        if (b.format != format || !b.vertexSpace.allocate(range.vertexCount, range.baseVertex))
+            continue;
+        if (!b.indexSpace.allocate(range.indexCount, range.firstIndex)) {
+            b.vertexSpace.release(range.baseVertex, range.vertexCount);
+            continue;
+        }
+        range.block = static_cast<int>(i);
+    }
+    if (!range.valid()) {
+        int b = addBlock(format, std::max(blockVertices, range.vertexCount), std::max(blockIndices, range.indexCount));
+        blocks[b].vertexSpace.allocate(range.vertexCount, range.baseVertex);
+        blocks[b].indexSpace.allocate(range.indexCount, range.firstIndex);
+        range.block = b;
+    }
+    return range;
+}
+
+ArenaRange GeometryArena::allocateIndices(const ArenaRange &vertices, size_t indexCount) {
+    ArenaRange range;
+    if (!vertices.valid())
+        return range;
+    range.baseVertex = vertices.baseVertex;
+    range.indexCount = static_cast<unsigned int>(indexCount);
+    if (blocks[vertices.block].indexSpace.allocate(range.indexCount, range.firstIndex))
+        range.block = vertices.block;
+    return range;
+}
+
+void GeometryArena::release(ArenaRange &range) {
+    if (!range.valid())
+        return;
+    Block &b = blocks[range.block];
+    b.vertexSpace.release(range.baseVertex, range.vertexCount);
+    b.indexSpace.release(range.firstIndex, range.indexCount);
+    range = ArenaRange();
+}
+
+size_t GeometryArena::usedVertices() const {
+    size_t used = 0;
+    for (const Block &b : blocks)
+        used += b.vertexSpace.used();
+    return used;
+}
+
+size_t GeometryArena::usedIndices() const {
+    size_t used = 0;
+    for (const Block &b : blocks)
+        used += b.indexSpace.used();
+    return used;
+}
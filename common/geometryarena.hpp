@@ -0,0 +1,94 @@
+#ifndef GEOMETRYARENA_HPP
+#define GEOMETRYARENA_HPP
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "vertexformat.hpp"
+
+// Free space of one arena buffer, in elements: first fit over free spans
+// ordered by offset, merged with their neighbours when released.
+class FreeList {
+public:
+    explicit FreeList(unsigned int capacity = 0);
+
+    bool allocate(unsigned int size, unsigned int &offset);
+    void release(unsigned int offset, unsigned int size);
+
+    unsigned int capacity() const { return total; }
+    unsigned int used() const { return total - available; }
+
+private:
+    std::map<unsigned int, unsigned int> spans; // Offset -> size
+    unsigned int total, available;
+};
+
+// Where a mesh lives in the arena. Its indices are stored as they are
+// (relative to the mesh) and drawn with glDrawElementsBaseVertex.
+struct ArenaRange {
+    int block = -1;
+    unsigned int baseVertex = 0, vertexCount = 0;
+    unsigned int firstIndex = 0, indexCount = 0;
+
+    bool valid() const { return block >= 0; }
+    const void *indexOffset() const { return reinterpret_cast<const void *>(size_t(firstIndex) * sizeof(unsigned int)); }
+};
+
+// Vertex and index storage for every mesh, in either VertexFormat (at
+// attributes 0-2) with 32-bit indices. Meshes are sub-allocated from a few
+// large blocks, each a set of GL buffers with one VAO over them, so
+// allocating or freeing a mesh creates and deletes no GL objects, and meshes
+// in the same block are drawn without changing the VAO. A block holds one
+// format; a mesh too large for a block gets a block of its own.
+//
+// GL thread only. Fill a range with glBufferSubData on the block's buffers
+// at the range's offsets (in vertices times the format's element sizes).
+class GeometryArena {
+public:
+    struct Block {
+        VertexFormat format = VertexFormat::Separate;
+        GLuint vertexArray = 0;
+        GLuint positions = 0, uvs = 0, normals = 0; // Separate streams
+        GLuint vertices = 0;                        // Interleaved PackedLayout vertices
+        GLuint indices = 0;
+        FreeList vertexSpace, indexSpace;
+    };
+
+    static GeometryArena &shared();
+
+    // Vertices and indices for one mesh, both in the same block. Never fails
+    // (short of GL running out of memory).
+    ArenaRange allocate(size_t vertexCount, size_t indexCount, VertexFormat format = VertexFormat::Separate);
+
+    // Index space next to the vertices of 'vertices', for other triangle lists
+    // over the same vertices (e.g. LODs). Invalid if that block is full.
+    ArenaRange allocateIndices(const ArenaRange &vertices, size_t indexCount);
+
+    // Frees both parts of 'range' (only the indices of one from
+    // allocateIndices) and invalidates it
+    void release(ArenaRange &range);
+
+    const Block &block(const ArenaRange &range) const { return blocks[range.block]; }
+
+    size_t blockCount() const { return blocks.size(); }
+    size_t usedVertices() const;
+    size_t usedIndices() const;
+
+    // Elements per block; a larger mesh gets a block of exactly its size
+    static constexpr unsigned int blockVertices = 1u << 18; // 8 MB over the three streams, 4 MB packed
+    static constexpr unsigned int blockIndices = 2u << 20;  // 8 MB
+
+private:
+    GeometryArena() {}
+    GeometryArena(const GeometryArena &) = delete;
+    GeometryArena &operator=(const GeometryArena &) = delete;
+
+    int addBlock(VertexFormat format, unsigned int vertexCapacity, unsigned int indexCapacity);
+
+    std::vector<Block> blocks;
+};
+
+#endif
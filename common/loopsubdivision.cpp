@@ -0,0 +1,358 @@
+#include <atomic>
+#include <cmath>
+#include <stdio.h>
+
+#include <glm/gtc/constants.hpp>
+
+#include "loopsubdivision.hpp"
+#include "meshtopology.hpp"
+#include "threadpool.hpp"
+#include "vertexcache.hpp"
+
+namespace {
+
+const size_t grain = 4096;
+
+// Loop's interior vertex weight for valence k
+float loopBeta(int k) {
+    if (k == 3)
+        return 3.0f / 16.0f;
+    float c = 3.0f / 8.0f + 0.25f * std::cos(2.0f * glm::pi<float>() / k);
+    return (1.0f / k) * (5.0f / 8.0f - c * c);
+}
+
+// Fills stencil r with the boundary vertex rule, corner rule or interior rule.
+// Returns the number of entries; with 'write' false only counts them.
+unsigned int vertexStencil(const MeshTopology &topology, unsigned int i, bool write, unsigned int *sources, float *weights) {
+    const unsigned int first = topology.vertexNeighborOffsets[i];
+    const unsigned int last = topology.vertexNeighborOffsets[i + 1];
+    const int k = static_cast<int>(last - first);
+
+    // A vertex is on the boundary if any of its edges is
+    unsigned int boundaryNeighbors[2];
+    int boundaryNeighborCount = 0;
+    for (unsigned int n = first; n < last; n++) {
+        if (topology.isBoundaryEdge(topology.vertexNeighborEdges[n])) {
+            if (boundaryNeighborCount < 2)
+                boundaryNeighbors[boundaryNeighborCount] = topology.vertexNeighbors[n];
+            boundaryNeighborCount++;
+        }
+    }
+
+    if (boundaryNeighborCount == 2) {
+        if (write) {
+            sources[0] = boundaryNeighbors[0]; weights[0] = 1.0f / 8.0f;
+            sources[1] = i;                    weights[1] = 6.0f / 8.0f;
+            sources[2] = boundaryNeighbors[1]; weights[2] = 1.0f / 8.0f;
+        }
+        return 3;
+    }
+    if (boundaryNeighborCount > 0 || k == 0) {
+        // Corner or isolated vertex: keeps its position
+        if (write) {
+            sources[0] = i;
+            weights[0] = 1.0f;
+        }
+        return 1;
+    }
+    if (write) {
+        float beta = loopBeta(k);
+        sources[0] = i;
+        weights[0] = 1.0f - k * beta;
+        for (int n = 0; n < k; n++) {
+            sources[n + 1] = topology.vertexNeighbors[first + n];
+            weights[n + 1] = beta;
+        }
+    }
+    return static_cast<unsigned int>(k + 1);
+}
+
+// Sets counts[t] to the entries of row v in table t (position, tangent 0,
+// tangent 1) and, when 'limit' is given, fills those rows.
+void limitStencil(const std::vector<unsigned int> &indices, const VertexCorners &corners, unsigned int v, LoopLimit *limit, unsigned int counts[3]) {
+    unsigned int ring[maxVertexRing];
+    bool boundary = false;
+    const int n = vertexRing(indices, corners, v, ring, boundary);
+
+    const bool write = limit != nullptr;
+    unsigned int *sources[3] = {};
+    float *weights[3] = {};
+    if (write) {
+        StencilTable *tables[3] = { &limit->positions, &limit->tangents[0], &limit->tangents[1] };
+        for (int t = 0; t < 3; t++) {
+            sources[t] = tables[t]->sources.data() + tables[t]->offsets[v];
+            weights[t] = tables[t]->weights.data() + tables[t]->offsets[v];
+        }
+    }
+
+    if (n == 0) {
+        // Corner: stays where it is and has no tangents of its own
+        counts[0] = 1; counts[1] = counts[2] = 0;
+        if (write) {
+            sources[0][0] = v;
+            weights[0][0] = 1.0f;
+        }
+        return;
+    }
+
+    if (!boundary) {
+        // Interior: v moves towards its neighbours by chi each; the tangents
+        // are the first Fourier components of the ring
+        counts[0] = n + 1; counts[1] = counts[2] = n;
+        if (!write)
+            return;
+        const float chi = 1.0f / (3.0f / (8.0f * loopBeta(n)) + n);
+        sources[0][0] = v;
+        weights[0][0] = 1.0f - n * chi;
+        for (int i = 0; i < n; i++) {
+            const float angle = 2.0f * glm::pi<float>() * i / n;
+            sources[0][i + 1] = sources[1][i] = sources[2][i] = ring[i];
+            weights[0][i + 1] = chi;
+            weights[1][i] = std::cos(angle);
+            weights[2][i] = std::sin(angle);
+        }
+        return;
+    }
+
+    // Boundary with k faces: the ring runs ring[0] .. ring[k] on the inside of the fan
+    const int k = n - 1;
+    counts[0] = 3;
+    counts[1] = 2;
+    counts[2] = (k == 1) ? 3 : (k == 2) ? 2 : n;
+    if (!write)
+        return;
+    sources[0][0] = ring[0]; weights[0][0] = 1.0f / 6.0f;
+    sources[0][1] = v;       weights[0][1] = 4.0f / 6.0f;
+    sources[0][2] = ring[k]; weights[0][2] = 1.0f / 6.0f;
+
+    // Along the boundary
+    sources[1][0] = ring[0]; weights[1][0] = 1.0f;
+    sources[1][1] = ring[k]; weights[1][1] = -1.0f;
+
+    // Across it, pointing into the surface
+    if (k == 1) {
+        sources[2][0] = ring[0]; weights[2][0] = 1.0f;
+        sources[2][1] = ring[1]; weights[2][1] = 1.0f;
+        sources[2][2] = v;       weights[2][2] = -2.0f;
+    } else if (k == 2) {
+        sources[2][0] = ring[1]; weights[2][0] = 1.0f;
+        sources[2][1] = v;       weights[2][1] = -1.0f;
+    } else {
+        const float theta = glm::pi<float>() / k;
+        for (int i = 0; i <= k; i++) {
+            sources[2][i] = ring[i];
+            weights[2][i] = (i == 0 || i == k) ? -std::sin(theta) : (2.0f - 2.0f * std::cos(theta)) * std::sin(i * theta);
+        }
+    }
+}
+
+template <typename Vec>
+void applyStencilsImpl(const StencilTable &stencils, const std::vector<Vec> &coarse, std::vector<Vec> &refined) {
+    refined.resize(stencils.size());
+    ThreadPool::shared().parallelFor(stencils.size(), grain, [&](size_t begin, size_t end) {
+        const unsigned int *offsets = stencils.offsets.data();
+        const unsigned int *sources = stencils.sources.data();
+        const float *weights = stencils.weights.data();
+        const Vec *in = coarse.data();
+        for (size_t r = begin; r < end; r++) {
+            Vec sum(0.0f);
+            for (unsigned int j = offsets[r]; j < offsets[r + 1]; j++)
+                sum += weights[j] * in[sources[j]];
+            refined[r] = sum;
+        }
+    });
+}
+
+// Moves stencil r to row remap[r]
+void permuteStencils(StencilTable &stencils, const std::vector<unsigned int> &remap) {
+    const size_t count = stencils.size();
+    StencilTable permuted;
+    permuted.offsets.assign(count + 1, 0);
+    for (size_t r = 0; r < count; r++)
+        permuted.offsets[remap[r] + 1] = stencils.offsets[r + 1] - stencils.offsets[r];
+    for (size_t r = 0; r < count; r++)
+        permuted.offsets[r + 1] += permuted.offsets[r];
+    permuted.sources.resize(stencils.sources.size());
+    permuted.weights.resize(stencils.weights.size());
+    ThreadPool::shared().parallelFor(count, grain, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; r++) {
+            const unsigned int from = stencils.offsets[r];
+            const unsigned int to = permuted.offsets[remap[r]];
+            for (unsigned int j = 0; j < stencils.offsets[r + 1] - from; j++) {
+                permuted.sources[to + j] = stencils.sources[from + j];
+                permuted.weights[to + j] = stencils.weights[from + j];
+            }
+        }
+    });
+    stencils = std::move(permuted);
+}
+
+} // namespace
+
+void buildLoopLevel(const std::vector<unsigned int> &coarseIndices, size_t coarseVertexCount, LoopLevel &level,
+                    VertexCacheStats *cacheBefore, VertexCacheStats *cacheAfter) {
+    ThreadPool &pool = ThreadPool::shared();
+    MeshTopology topology;
+    buildMeshTopology(coarseIndices, coarseVertexCount, topology);
+    const size_t edgeCount = topology.edgeCount();
+    const size_t refinedCount = coarseVertexCount + edgeCount;
+
+    // Stencil sizes, then their offsets
+    StencilTable &stencils = level.stencils;
+    stencils.offsets.assign(refinedCount + 1, 0);
+    pool.parallelFor(refinedCount, grain, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; r++) {
+            if (r < coarseVertexCount)
+                stencils.offsets[r + 1] = vertexStencil(topology, static_cast<unsigned int>(r), false, nullptr, nullptr);
+            else
+                stencils.offsets[r + 1] = topology.edgeFaceCount(r - coarseVertexCount) == 2 ? 4 : 2;
+        }
+    });
+    for (size_t r = 0; r < refinedCount; r++)
+        stencils.offsets[r + 1] += stencils.offsets[r];
+
+    stencils.sources.resize(stencils.offsets[refinedCount]);
+    stencils.weights.resize(stencils.offsets[refinedCount]);
+    std::atomic<size_t> nonManifoldEdges(0);
+    pool.parallelFor(refinedCount, grain, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; r++) {
+            unsigned int *sources = &stencils.sources[stencils.offsets[r]];
+            float *weights = &stencils.weights[stencils.offsets[r]];
+            if (r < coarseVertexCount) {
+                vertexStencil(topology, static_cast<unsigned int>(r), true, sources, weights);
+                continue;
+            }
+
+            const size_t e = r - coarseVertexCount;
+            const unsigned int faceCount = topology.edgeFaceCount(e);
+            sources[0] = topology.edgeLow[e];
+            sources[1] = topology.edgeHigh[e];
+            if (faceCount == 2) {
+                // Interior edge: the opposite vertex is the corner after the half-edge's end
+                unsigned int h1 = topology.edgeHalfEdges[topology.edgeHalfEdgeOffsets[e]];
+                unsigned int h2 = topology.edgeHalfEdges[topology.edgeHalfEdgeOffsets[e] + 1];
+                sources[2] = coarseIndices[h1 - h1 % 3 + (h1 + 2) % 3];
+                sources[3] = coarseIndices[h2 - h2 % 3 + (h2 + 2) % 3];
+                weights[0] = weights[1] = 3.0f / 8.0f;
+                weights[2] = weights[3] = 1.0f / 8.0f;
+            } else {
+                // Boundary edge, or a non-manifold one falling back to the boundary rule
+                if (faceCount > 2)
+                    nonManifoldEdges++;
+                weights[0] = weights[1] = 0.5f;
+            }
+        }
+    });
+    if (nonManifoldEdges > 0)
+        printf("Warning: %zu edges with more than 2 faces; using their midpoints.\n", static_cast<size_t>(nonManifoldEdges));
+
+    // Four triangles per coarse triangle; the midpoint of half-edge h is the
+    // refined vertex of the edge it lies on
+    const size_t faceCount = coarseIndices.size() / 3;
+    level.indices.resize(faceCount * 12);
+    pool.parallelFor(faceCount, grain, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; f++) {
+            const size_t i = f * 3;
+            unsigned int v0 = coarseIndices[i];
+            unsigned int v1 = coarseIndices[i + 1];
+            unsigned int v2 = coarseIndices[i + 2];
+            unsigned int m01 = static_cast<unsigned int>(coarseVertexCount) + topology.halfEdgeEdge[i];
+            unsigned int m12 = static_cast<unsigned int>(coarseVertexCount) + topology.halfEdgeEdge[i + 1];
+            unsigned int m20 = static_cast<unsigned int>(coarseVertexCount) + topology.halfEdgeEdge[i + 2];
+
+            unsigned int *out = &level.indices[f * 12];
+            out[0] = v0;  out[1] = m01;  out[2] = m20;
+            out[3] = v1;  out[4] = m12;  out[5] = m01;
+            out[6] = v2;  out[7] = m20;  out[8] = m12;
+            out[9] = m01; out[10] = m12; out[11] = m20;
+        }
+    });
+
+    // The fixed four-child pattern reuses few vertices; reorder the triangles
+    // for the post-transform cache, then the refined vertices (stencil rows)
+    // for fetch
+    if (cacheBefore)
+        *cacheBefore = analyzeVertexCache(level.indices, refinedCount);
+    std::vector<unsigned int> ordered;
+    optimizeVertexCache(level.indices, refinedCount, ordered);
+    level.indices.swap(ordered);
+    std::vector<unsigned int> remap;
+    optimizeVertexFetch(level.indices, refinedCount, remap);
+    permuteStencils(stencils, remap);
+    if (cacheAfter)
+        *cacheAfter = analyzeVertexCache(level.indices, refinedCount);
+
+    buildVertexCornerTable(level.indices, level.vertexCount(), level.corners);
+}
+
+void applyStencils(const StencilTable &stencils, const std::vector<glm::vec3> &coarse, std::vector<glm::vec3> &refined) {
+    applyStencilsImpl(stencils, coarse, refined);
+}
+
+void applyStencils(const StencilTable &stencils, const std::vector<glm::vec2> &coarse, std::vector<glm::vec2> &refined) {
+    applyStencilsImpl(stencils, coarse, refined);
+}
+
+void buildLoopLimit(const std::vector<unsigned int> &indices, size_t vertexCount, const VertexCorners &corners, LoopLimit &limit) {
+    ThreadPool &pool = ThreadPool::shared();
+    StencilTable *tables[3] = { &limit.positions, &limit.tangents[0], &limit.tangents[1] };
+
+    // Row sizes, then offsets, then the rows themselves
+    for (int t = 0; t < 3; t++)
+        tables[t]->offsets.assign(vertexCount + 1, 0);
+    pool.parallelFor(vertexCount, grain, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+            unsigned int counts[3];
+            limitStencil(indices, corners, static_cast<unsigned int>(v), nullptr, counts);
+            for (int t = 0; t < 3; t++)
+                tables[t]->offsets[v + 1] = counts[t];
+        }
+    });
+    for (int t = 0; t < 3; t++) {
+        std::vector<unsigned int> &offsets = tables[t]->offsets;
+        for (size_t v = 0; v < vertexCount; v++)
+            offsets[v + 1] += offsets[v];
+        tables[t]->sources.resize(offsets[vertexCount]);
+        tables[t]->weights.resize(offsets[vertexCount]);
+    }
+    pool.parallelFor(vertexCount, grain, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+            unsigned int counts[3];
+            limitStencil(indices, corners, static_cast<unsigned int>(v), &limit, counts);
+        }
+    });
+}
+
+void evaluateLoopLimit(const LoopLimit &limit, const std::vector<unsigned int> &indices, const VertexCorners &corners,
+                       const std::vector<glm::vec3> &control, std::vector<glm::vec3> &positions, std::vector<glm::vec3> &normals) {
+    applyStencils(limit.positions, control, positions);
+
+    const size_t vertexCount = limit.positions.size();
+    normals.resize(vertexCount);
+    ThreadPool::shared().parallelFor(vertexCount, grain, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+            glm::vec3 tangents[2];
+            for (int t = 0; t < 2; t++) {
+                const StencilTable &table = limit.tangents[t];
+                tangents[t] = glm::vec3(0.0f);
+                for (unsigned int j = table.offsets[v]; j < table.offsets[v + 1]; j++)
+                    tangents[t] += table.weights[j] * control[table.sources[j]];
+            }
+            glm::vec3 normal = glm::cross(tangents[0], tangents[1]);
+
+            if (!(glm::dot(normal, normal) > 0.0f)) {
+                normal = glm::vec3(0.0f);
+                for (unsigned int j = corners.offsets[v]; j < corners.offsets[v + 1]; j++) {
+                    const unsigned int f = corners.corners[j] - corners.corners[j] % 3;
+                    const glm::vec3 &a = positions[indices[f]];
+                    glm::vec3 faceNormal = glm::cross(positions[indices[f + 1]] - a, positions[indices[f + 2]] - a);
+                    float length = glm::length(faceNormal);
+                    if (length > 0.0f)
+                        normal += faceNormal / length;
+                }
+            }
+            float length = glm::length(normal);
+            normals[v] = (length > 0.0f) ? normal / length : glm::vec3(0.0f);
+        }
+    });
+}
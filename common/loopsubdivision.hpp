@@ -0,0 +1,66 @@
+#ifndef LOOPSUBDIVISION_HPP
+#define LOOPSUBDIVISION_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "meshtopology.hpp"
+#include "vertexcache.hpp"
+
+// One Loop refinement step as a sparse matrix: refined vertex r is
+// sum(weights[j] * coarse[sources[j]]) over j in [offsets[r], offsets[r + 1]).
+// There is one refined vertex per coarse vertex and one per coarse edge, in
+// the order the refined triangles first use them. Positions and UVs use the
+// same weights.
+struct StencilTable {
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> sources;
+    std::vector<float> weights;
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+};
+
+// Everything one refinement step needs that depends only on connectivity.
+// Build it once, then re-evaluate it for any coarse positions.
+struct LoopLevel {
+    StencilTable stencils;
+    std::vector<unsigned int> indices; // Refined triangles, four per coarse triangle, in vertex cache order
+    VertexCorners corners;             // Of 'indices', for recomputing normals
+
+    size_t vertexCount() const { return stencils.size(); }
+};
+
+// Builds the stencils and refined triangles of one Loop step over the given
+// coarse triangles. The triangles are reordered for the post-transform vertex
+// cache and the refined vertices for fetch; the cache statistics of the plain
+// four-child order and of the result are written if asked for.
+void buildLoopLevel(const std::vector<unsigned int> &coarseIndices, size_t coarseVertexCount, LoopLevel &level,
+                    VertexCacheStats *cacheBefore = nullptr, VertexCacheStats *cacheAfter = nullptr);
+
+// refined = stencils * coarse. Runs on ThreadPool::shared().
+void applyStencils(const StencilTable &stencils, const std::vector<glm::vec3> &coarse, std::vector<glm::vec3> &refined);
+void applyStencils(const StencilTable &stencils, const std::vector<glm::vec2> &coarse, std::vector<glm::vec2> &refined);
+
+// Where infinitely many Loop steps would take each vertex of a control mesh,
+// and the surface tangents there, as masks over the control points. Interior
+// vertices use the valence-dependent masks of Loop's limit surface; boundary
+// vertices the cubic B-spline limit along the boundary with the boundary
+// tangent masks of Hoppe et al. Vertices whose one-ring is not a single fan
+// (corners, non-manifold) keep their position and get no tangent rows.
+struct LoopLimit {
+    StencilTable positions;
+    StencilTable tangents[2]; // Normal = cross(tangents[0], tangents[1]), facing the triangles' front side
+};
+
+// Builds the limit masks of a control mesh; 'corners' must be its vertex-corner table.
+void buildLoopLimit(const std::vector<unsigned int> &indices, size_t vertexCount, const VertexCorners &corners, LoopLimit &limit);
+
+// Limit positions and unit limit normals of the given control points. Vertices
+// without limit tangents (or with degenerate ones) fall back to the average of
+// their faces' normals on the limit positions.
+void evaluateLoopLimit(const LoopLimit &limit, const std::vector<unsigned int> &indices, const VertexCorners &corners,
+                       const std::vector<glm::vec3> &control, std::vector<glm::vec3> &positions, std::vector<glm::vec3> &normals);
+
+#endif
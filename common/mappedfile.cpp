@@ -0,0 +1,139 @@
+#include "mappedfile.hpp"
+
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : ptr(nullptr), length(0), opened(false) {
+#ifdef _WIN32
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = NULL;
+#endif
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char *path) {
+    close();
+
+    fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    opened = true;
+
+    // Zero-length files cannot be mapped; they are simply empty views.
+    if (length == 0)
+        return true;
+
+    mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mappingHandle == NULL) {
+        close();
+        return false;
+    }
+    ptr = static_cast<const char *>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (ptr == nullptr) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::discard(const char *begin, const char *end) const {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    uintptr_t page = info.dwPageSize;
+    uintptr_t first = (reinterpret_cast<uintptr_t>(begin) + page - 1) & ~(page - 1);
+    uintptr_t last = reinterpret_cast<uintptr_t>(end) & ~(page - 1);
+    // Unlocking pages that are not locked removes them from the working set
+    if (ptr != nullptr && last > first)
+        VirtualUnlock(reinterpret_cast<void *>(first), last - first);
+}
+
+void MappedFile::close() {
+    if (ptr != nullptr)
+        UnmapViewOfFile(ptr);
+    if (mappingHandle != NULL)
+        CloseHandle(mappingHandle);
+    if (fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(fileHandle);
+    ptr = nullptr;
+    length = 0;
+    opened = false;
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = NULL;
+}
+
+#else
+
+bool MappedFile::open(const char *path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<size_t>(st.st_size);
+    opened = true;
+
+    // Zero-length files cannot be mapped; they are simply empty views.
+    if (length == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps its own reference to the file
+    if (mapped == MAP_FAILED) {
+        length = 0;
+        opened = false;
+        return false;
+    }
+    madvise(mapped, length, MADV_SEQUENTIAL);
+    ptr = static_cast<const char *>(mapped);
+    return true;
+}
+
+void MappedFile::discard(const char *begin, const char *end) const {
+    uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t first = (reinterpret_cast<uintptr_t>(begin) + page - 1) & ~(page - 1);
+    uintptr_t last = reinterpret_cast<uintptr_t>(end) & ~(page - 1);
+    if (ptr != nullptr && last > first)
+        madvise(reinterpret_cast<void *>(first), last - first, MADV_DONTNEED);
+}
+
+void MappedFile::close() {
+    if (ptr != nullptr)
+        munmap(const_cast<char *>(ptr), length);
+    ptr = nullptr;
+    length = 0;
+    opened = false;
+}
+
+#endif
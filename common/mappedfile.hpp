@@ -0,0 +1,37 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+
+// Read-only view of a whole file mapped into memory.
+// The contents stay valid until close() or destruction.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const char *path);
+    void close();
+
+    const char *data() const { return ptr; }
+    size_t size() const { return length; }
+    bool isOpen() const { return opened; }
+
+    // Hints that [begin, end) has been consumed: its pages are dropped from
+    // the resident set (they are re-read from the file if touched again).
+    void discard(const char *begin, const char *end) const;
+
+private:
+    const char *ptr;
+    size_t length;
+    bool opened;
+#ifdef _WIN32
+    void *fileHandle;
+    void *mappingHandle;
+#endif
+};
+
+#endif
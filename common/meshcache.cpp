@@ -0,0 +1,263 @@
+#include <vector>
+#include <stdio.h>
+#include <string>
+#include <cstring>
+#include <atomic>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include <glm/glm.hpp>
+
+#include "meshcache.hpp"
+#include "mappedfile.hpp"
+#include "objloader.hpp"
+#include "vertexcache.hpp"
+
+namespace {
+
+const char meshBinMagic[8] = { 'M', 'E', 'S', 'H', 'B', 'I', 'N', '\0' };
+const uint32_t byteOrderMark = 0x01020304u;
+const size_t sectionAlignment = 16;
+
+enum MeshBinSection {
+    SECTION_POSITIONS,
+    SECTION_UVS,
+    SECTION_NORMALS,
+    SECTION_INDICES,
+    SECTION_COUNT
+};
+
+struct MeshBinSectionInfo {
+    uint64_t offset;  // From the start of the file, 16-byte aligned
+    uint32_t count;   // Number of elements
+    uint32_t stride;  // Bytes per element
+};
+
+struct MeshBinHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t headerSize;
+    uint32_t sectionCount;
+    uint64_t sourceHash;
+    uint64_t fileSize;
+    MeshBinSectionInfo sections[SECTION_COUNT];
+};
+
+static_assert(sizeof(MeshBinSectionInfo) == 16, "meshbin section info must be packed");
+static_assert(sizeof(MeshBinHeader) == 40 + 16 * SECTION_COUNT, "meshbin header must be packed");
+
+inline uint64_t alignUp(uint64_t value) {
+    return (value + sectionAlignment - 1) & ~static_cast<uint64_t>(sectionAlignment - 1);
+}
+
+inline uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+template <typename T>
+bool copySection(const char *base, const MeshBinSectionInfo &info, std::vector<T> &out) {
+    if (info.stride != sizeof(T))
+        return false;
+    out.resize(info.count);
+    if (info.count > 0)
+        memcpy(out.data(), base + info.offset, static_cast<size_t>(info.count) * sizeof(T));
+    return true;
+}
+
+} // namespace
+
+uint64_t hashBytes(const void *data, size_t size, uint64_t seed) {
+    // Four independent multiply-rotate lanes over 8-byte words, folded at the end
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    uint64_t lanes[4] = { prime ^ seed, prime ^ 1 ^ seed, prime ^ 2 ^ seed, prime ^ 3 ^ seed };
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int l = 0; l < 4; l++) {
+            uint64_t word;
+            memcpy(&word, p + i + 8 * l, 8);
+            lanes[l] = (lanes[l] ^ word) * prime;
+            lanes[l] = (lanes[l] << 31) | (lanes[l] >> 33);
+        }
+    }
+    uint64_t h = static_cast<uint64_t>(size) ^ seed;
+    for (int l = 0; l < 4; l++)
+        h = mix(h ^ lanes[l]);
+    for (; i < size; i++)
+        h = (h ^ p[i]) * prime;
+    return mix(h);
+}
+
+bool writeMeshBin(
+    const char *path,
+    uint64_t sourceHash,
+    const std::vector<glm::vec3> &vertices,
+    const std::vector<glm::vec2> &uvs,
+    const std::vector<glm::vec3> &normals,
+    const std::vector<unsigned int> &indices
+) {
+    MeshBinHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, meshBinMagic, sizeof(meshBinMagic));
+    header.version = MESHBIN_VERSION;
+    header.byteOrder = byteOrderMark;
+    header.headerSize = sizeof(MeshBinHeader);
+    header.sectionCount = SECTION_COUNT;
+    header.sourceHash = sourceHash;
+
+    const void *payloads[SECTION_COUNT] = { vertices.data(), uvs.data(), normals.data(), indices.data() };
+    const size_t counts[SECTION_COUNT] = { vertices.size(), uvs.size(), normals.size(), indices.size() };
+    const uint32_t strides[SECTION_COUNT] = { sizeof(glm::vec3), sizeof(glm::vec2), sizeof(glm::vec3), sizeof(unsigned int) };
+
+    uint64_t offset = alignUp(sizeof(MeshBinHeader));
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        header.sections[s].offset = offset;
+        header.sections[s].count = static_cast<uint32_t>(counts[s]);
+        header.sections[s].stride = strides[s];
+        offset = alignUp(offset + counts[s] * strides[s]);
+    }
+    header.fileSize = offset;
+
+    // Write to a temporary name and rename it into place, so readers never see half a file.
+    // Loads run on worker threads and in other processes, so each writer gets a name of its own.
+    static std::atomic<unsigned int> writerCount(0);
+    std::string tempPath = std::string(path) + "." + std::to_string(getpid()) + "." + std::to_string(writerCount++) + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if (file == NULL)
+        return false;
+
+    const char padding[sectionAlignment] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t written = sizeof(header);
+    for (int s = 0; s < SECTION_COUNT && ok; s++) {
+        ok = fwrite(padding, 1, header.sections[s].offset - written, file) == header.sections[s].offset - written;
+        written = header.sections[s].offset;
+        size_t bytes = counts[s] * strides[s];
+        if (ok && bytes > 0)
+            ok = fwrite(payloads[s], 1, bytes, file) == bytes;
+        written += bytes;
+    }
+    if (ok)
+        ok = fwrite(padding, 1, header.fileSize - written, file) == header.fileSize - written;
+    ok = (fclose(file) == 0) && ok;
+
+    if (ok) {
+        ok = rename(tempPath.c_str(), path) == 0; // Atomically replaces a cache another writer published
+#ifdef _WIN32
+        if (!ok) {
+            remove(path); // rename() does not replace existing files on Windows
+            ok = rename(tempPath.c_str(), path) == 0;
+        }
+#endif
+    }
+    if (!ok)
+        remove(tempPath.c_str());
+    return ok;
+}
+
+bool readMeshBin(
+    const char *path,
+    uint64_t expectedSourceHash,
+    std::vector<glm::vec3> &out_vertices,
+    std::vector<glm::vec2> &out_uvs,
+    std::vector<glm::vec3> &out_normals,
+    std::vector<unsigned int> &out_indices
+) {
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(MeshBinHeader))
+        return false;
+
+    MeshBinHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, meshBinMagic, sizeof(meshBinMagic)) != 0 ||
+        header.version != MESHBIN_VERSION ||
+        header.byteOrder != byteOrderMark ||
+        header.headerSize != sizeof(MeshBinHeader) ||
+        header.sectionCount != SECTION_COUNT ||
+        header.fileSize != file.size() ||
+        header.sourceHash != expectedSourceHash)
+        return false;
+
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        const MeshBinSectionInfo &info = header.sections[s];
+        if (info.offset % sectionAlignment != 0 ||
+            info.offset > header.fileSize ||
+            static_cast<uint64_t>(info.count) * info.stride > header.fileSize - info.offset)
+            return false;
+    }
+
+    bool ok = copySection(file.data(), header.sections[SECTION_POSITIONS], out_vertices) &&
+              copySection(file.data(), header.sections[SECTION_UVS], out_uvs) &&
+              copySection(file.data(), header.sections[SECTION_NORMALS], out_normals) &&
+              copySection(file.data(), header.sections[SECTION_INDICES], out_indices);
+
+    // Every vertex needs all three attributes and every index must be in range
+    if (ok) {
+        ok = out_uvs.size() == out_vertices.size() && out_normals.size() == out_vertices.size();
+        for (size_t i = 0; ok && i < out_indices.size(); i++)
+            ok = out_indices[i] < out_vertices.size();
+    }
+    if (!ok) {
+        out_vertices.clear();
+        out_uvs.clear();
+        out_normals.clear();
+        out_indices.clear();
+    }
+    return ok;
+}
+
+bool loadOBJCached(
+    const char *path,
+    std::vector<glm::vec3> &out_vertices,
+    std::vector<glm::vec2> &out_uvs,
+    std::vector<glm::vec3> &out_normals,
+    std::vector<unsigned int> &out_indices
+) {
+    std::string cachePath = std::string(path) + ".meshbin";
+
+    uint64_t sourceHash = 0;
+    {
+        MappedFile source;
+        if (!source.open(path))
+            return loadOBJ(path, out_vertices, out_uvs, out_normals, out_indices); // Reports the error
+        sourceHash = hashBytes(source.data(), source.size());
+    }
+
+    if (readMeshBin(cachePath.c_str(), sourceHash, out_vertices, out_uvs, out_normals, out_indices)) {
+        printf("Loaded compiled mesh %s\n", cachePath.c_str());
+        return true;
+    }
+
+    if (!loadOBJ(path, out_vertices, out_uvs, out_normals, out_indices))
+        return false;
+
+    // Stored in draw order, so the optimization is paid once per source file
+    const size_t vertexCount = out_vertices.size();
+    VertexCacheStats before = analyzeVertexCache(out_indices, vertexCount);
+    std::vector<unsigned int> ordered;
+    optimizeVertexCache(out_indices, vertexCount, ordered);
+    out_indices.swap(ordered);
+    std::vector<unsigned int> remap;
+    optimizeVertexFetch(out_indices, vertexCount, remap);
+    remapVertices(out_vertices, remap);
+    remapVertices(out_uvs, remap);
+    remapVertices(out_normals, remap);
+    VertexCacheStats after = analyzeVertexCache(out_indices, vertexCount);
+    printf("Vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", before.acmr, after.acmr, before.atvr, after.atvr);
+
+    if (!writeMeshBin(cachePath.c_str(), sourceHash, out_vertices, out_uvs, out_normals, out_indices))
+        printf("Could not write compiled mesh %s\n", cachePath.c_str());
+    return true;
+}
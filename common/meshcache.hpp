@@ -0,0 +1,55 @@
+#ifndef MESHCACHE_HPP
+#define MESHCACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Compiled-mesh cache (.meshbin).
+//
+// A .meshbin file is a fixed header followed by the raw position, UV, normal
+// and index arrays, each 16-byte aligned, exactly as they are uploaded to GL.
+// The header records the layout (element counts, strides and offsets) and a
+// hash of the OBJ text it was built from, so a stale cache is detected and
+// rebuilt instead of being trusted.
+
+// Bumped whenever the layout or the OBJ loader's output changes.
+const uint32_t MESHBIN_VERSION = 2;
+
+// 64-bit content hash used to tag caches with their source file. Other seeds
+// give further hashes of the same bytes, independent of the unseeded one.
+uint64_t hashBytes(const void *data, size_t size, uint64_t seed = 0);
+
+bool writeMeshBin(
+    const char *path,
+    uint64_t sourceHash,
+    const std::vector<glm::vec3> &vertices,
+    const std::vector<glm::vec2> &uvs,
+    const std::vector<glm::vec3> &normals,
+    const std::vector<unsigned int> &indices
+);
+
+// Maps 'path' and copies its arrays out. Fails (leaving the outputs empty) if
+// the file is missing, malformed, of another version or built from other source.
+bool readMeshBin(
+    const char *path,
+    uint64_t expectedSourceHash,
+    std::vector<glm::vec3> &out_vertices,
+    std::vector<glm::vec2> &out_uvs,
+    std::vector<glm::vec3> &out_normals,
+    std::vector<unsigned int> &out_indices
+);
+
+// Drop-in replacement for loadOBJ that goes through "<path>.meshbin".
+// A fresh cache is read directly; otherwise the OBJ is parsed, its triangles
+// and vertices reordered for the GPU vertex cache and fetch (see
+// vertexcache.hpp) and the cache (re)written next to it. The mesh is the
+// same as loadOBJ's, only stored in a different order.
+bool loadOBJCached(
+    const char *path,
+    std::vector<glm::vec3> &out_vertices,
+    std::vector<glm::vec2> &out_uvs,
+    std::vector<glm::vec3> &out_normals,
+    std::vector<unsigned int> &out_indices
+);
+
+#endif
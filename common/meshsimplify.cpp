@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "meshsimplify.hpp"
+#include "meshtopology.hpp"
+#include "threadpool.hpp"
+#include "tripleindexmap.hpp"
+
+namespace {
+
+const size_t grain = 4096;
+const unsigned int noVertex = 0xFFFFFFFFu;
+
+// A collapse may tilt a surviving triangle by at most this (cosine of ~78 degrees)
+const float minNormalCosine = 0.2f;
+
+// Sum of squared distances to a set of area-weighted planes, as the symmetric
+// matrix A, vector b and constant c of p^T A p + 2 b.p + c
+struct Quadric {
+    double a2, ab, ac, b2, bc, c2;
+    double ad, bd, cd;
+    double d2;
+    double weight; // Summed plane area, to turn the error back into a distance
+};
+
+void addPlane(Quadric &q, const glm::vec3 &n, float d, float area) {
+    q.a2 += area * n.x * n.x; q.ab += area * n.x * n.y; q.ac += area * n.x * n.z;
+    q.b2 += area * n.y * n.y; q.bc += area * n.y * n.z; q.c2 += area * n.z * n.z;
+    q.ad += area * n.x * d;   q.bd += area * n.y * d;   q.cd += area * n.z * d;
+    q.d2 += area * d * d;
+    q.weight += area;
+}
+
+void addQuadric(Quadric &q, const Quadric &r) {
+    q.a2 += r.a2; q.ab += r.ab; q.ac += r.ac;
+    q.b2 += r.b2; q.bc += r.bc; q.c2 += r.c2;
+    q.ad += r.ad; q.bd += r.bd; q.cd += r.cd;
+    q.d2 += r.d2;
+    q.weight += r.weight;
+}
+
+// RMS distance from p to the quadric's planes
+float quadricError(const Quadric &q, const Quadric &r, const glm::vec3 &p) {
+    double x = p.x, y = p.y, z = p.z;
+    double a2 = q.a2 + r.a2, ab = q.ab + r.ab, ac = q.ac + r.ac;
+    double b2 = q.b2 + r.b2, bc = q.bc + r.bc, c2 = q.c2 + r.c2;
+    double ad = q.ad + r.ad, bd = q.bd + r.bd, cd = q.cd + r.cd;
+    double weight = q.weight + r.weight;
+    double sum = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + b2 * y * y + 2 * bc * y * z + c2 * z * z
+               + 2 * (ad * x + bd * y + cd * z) + q.d2 + r.d2;
+    return (weight > 0.0 && sum > 0.0) ? static_cast<float>(std::sqrt(sum / weight)) : 0.0f;
+}
+
+struct Collapse {
+    float error;
+    unsigned int from, to;
+};
+
+// Whether vertex v shares a triangle with w
+bool adjacent(const std::vector<unsigned int> &indices, const VertexCorners &corners, unsigned int v, unsigned int w) {
+    for (unsigned int j = corners.offsets[v]; j < corners.offsets[v + 1]; j++) {
+        const unsigned int c = corners.corners[j];
+        if (indices[c - c % 3 + (c + 1) % 3] == w || indices[c - c % 3 + (c + 2) % 3] == w)
+            return true;
+    }
+    return false;
+}
+
+// Whether merging u (with the given closed one-ring) into v keeps the mesh
+// manifold and does not fold any surviving triangle over
+bool canCollapse(const std::vector<glm::vec3> &positions, const std::vector<unsigned int> &indices, const VertexCorners &corners,
+                 unsigned int u, unsigned int v, const unsigned int *ring, int n) {
+    // Link condition: only the two vertices across the edge may be neighbours of both
+    int shared = 0;
+    for (int i = 0; i < n; i++)
+        if (ring[i] != v && adjacent(indices, corners, v, ring[i]))
+            shared++;
+    if (shared != 2)
+        return false;
+
+    for (unsigned int j = corners.offsets[u]; j < corners.offsets[u + 1]; j++) {
+        const unsigned int c = corners.corners[j];
+        const unsigned int b = indices[c - c % 3 + (c + 1) % 3];
+        const unsigned int d = indices[c - c % 3 + (c + 2) % 3];
+        if (b == v || d == v)
+            continue; // Removed by the collapse
+        const glm::vec3 &pb = positions[b];
+        const glm::vec3 &pd = positions[d];
+        glm::vec3 before = glm::cross(pb - positions[u], pd - positions[u]);
+        glm::vec3 after = glm::cross(pb - positions[v], pd - positions[v]);
+        float afterLength = glm::length(after);
+        if (afterLength == 0.0f || glm::dot(before, after) <= minNormalCosine * glm::length(before) * afterLength)
+            return false;
+    }
+    return true;
+}
+
+// One round of non-overlapping collapses, cheapest first. Returns how many
+// were made; each removes two triangles.
+size_t collapsePass(const std::vector<glm::vec3> &positions, const std::vector<unsigned char> &locked, std::vector<Quadric> &quadrics,
+                    std::vector<unsigned int> &indices, size_t maxCollapses, float &maxError) {
+    ThreadPool &pool = ThreadPool::shared();
+    const size_t vertexCount = positions.size();
+    VertexCorners corners;
+    buildVertexCornerTable(indices, vertexCount, corners);
+
+    // Every removable vertex proposes its cheapest neighbour
+    std::vector<Collapse> proposals(vertexCount);
+    pool.parallelFor(vertexCount, grain, [&](size_t begin, size_t end) {
+        unsigned int ring[maxVertexRing];
+        for (size_t u = begin; u < end; u++) {
+            Collapse &best = proposals[u];
+            best.error = std::numeric_limits<float>::max();
+            best.from = static_cast<unsigned int>(u);
+            best.to = noVertex;
+            if (locked[u])
+                continue;
+            bool boundary = false;
+            int n = vertexRing(indices, corners, static_cast<unsigned int>(u), ring, boundary);
+            if (n == 0 || boundary)
+                continue;
+            for (int i = 0; i < n; i++) {
+                float error = quadricError(quadrics[u], quadrics[ring[i]], positions[ring[i]]);
+                if (error < best.error) {
+                    best.error = error;
+                    best.to = ring[i];
+                }
+            }
+        }
+    });
+    proposals.erase(std::remove_if(proposals.begin(), proposals.end(), [](const Collapse &c) { return c.to == noVertex; }), proposals.end());
+    std::sort(proposals.begin(), proposals.end(), [](const Collapse &a, const Collapse &b) { return a.error < b.error; });
+
+    // Only the cheaper part goes in one round, so that cheap collapses blocked
+    // by a neighbour this time are not overtaken by expensive ones
+    size_t limit = std::min(maxCollapses, std::max<size_t>(1, (proposals.size() + 2) / 3));
+
+    // A collapse rewrites the triangles around its vertex, so no two may share
+    // a one-ring within a round
+    std::vector<unsigned char> touched(vertexCount, 0);
+    std::vector<unsigned int> remap;
+    size_t collapses = 0;
+    unsigned int ring[maxVertexRing];
+    for (size_t i = 0; i < proposals.size() && collapses < limit; i++) {
+        const unsigned int u = proposals[i].from;
+        const unsigned int v = proposals[i].to;
+        if (touched[u] || touched[v])
+            continue;
+        bool boundary = false;
+        int n = vertexRing(indices, corners, u, ring, boundary);
+        bool clear = true;
+        for (int j = 0; j < n && clear; j++)
+            clear = !touched[ring[j]];
+        if (!clear || !canCollapse(positions, indices, corners, u, v, ring, n))
+            continue;
+
+        if (remap.empty()) {
+            remap.resize(vertexCount);
+            for (size_t w = 0; w < vertexCount; w++)
+                remap[w] = static_cast<unsigned int>(w);
+        }
+        remap[u] = v;
+        addQuadric(quadrics[v], quadrics[u]);
+        maxError = std::max(maxError, proposals[i].error);
+        touched[u] = 1;
+        for (int j = 0; j < n; j++)
+            touched[ring[j]] = 1;
+        collapses++;
+    }
+    if (collapses == 0)
+        return 0;
+
+    // Redirect the collapsed vertices and drop the triangles that lost an edge
+    size_t out = 0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        unsigned int a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+        if (a == b || b == c || c == a)
+            continue;
+        indices[out++] = a;
+        indices[out++] = b;
+        indices[out++] = c;
+    }
+    indices.resize(out);
+    return collapses;
+}
+
+} // namespace
+
+void simplifyMeshChain(
+    const std::vector<glm::vec3> &positions,
+    const std::vector<unsigned int> &indices,
+    const std::vector<size_t> &targetTriangleCounts,
+    std::vector<std::vector<unsigned int>> &out_indices,
+    std::vector<float> &out_errors
+) {
+    ThreadPool &pool = ThreadPool::shared();
+    const size_t vertexCount = positions.size();
+    out_indices.clear();
+    out_errors.clear();
+
+    std::vector<unsigned int> current;
+    current.reserve(indices.size());
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        if (indices[i] != indices[i + 1] && indices[i + 1] != indices[i + 2] && indices[i + 2] != indices[i])
+            current.insert(current.end(), &indices[i], &indices[i] + 3);
+    }
+
+    // Seams: a position shared by several vertices. Welded on the exact bits
+    // (with -0 folded into +0), as the loader produces them.
+    std::vector<unsigned char> locked(vertexCount, 0);
+    {
+        TripleIndexMap positionMap(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++) {
+            unsigned int key[3];
+            const glm::vec3 p = positions[v] + glm::vec3(0.0f);
+            memcpy(key, &p.x, sizeof(key));
+            bool inserted = false;
+            unsigned int first = positionMap.findOrInsert(key[0], key[1], key[2], static_cast<unsigned int>(v), inserted);
+            if (!inserted)
+                locked[v] = locked[first] = 1;
+        }
+    }
+
+    // Boundaries and non-manifold fans, which collapses never create
+    VertexCorners corners;
+    buildVertexCornerTable(current, vertexCount, corners);
+    pool.parallelFor(vertexCount, grain, [&](size_t begin, size_t end) {
+        unsigned int ring[maxVertexRing];
+        for (size_t v = begin; v < end; v++) {
+            if (corners.offsets[v] == corners.offsets[v + 1])
+                continue;
+            bool boundary = false;
+            if (vertexRing(current, corners, static_cast<unsigned int>(v), ring, boundary) == 0 || boundary)
+                locked[v] = 1;
+        }
+    });
+
+    // Every vertex starts with the planes of its triangles
+    std::vector<Quadric> quadrics(vertexCount);
+    memset(quadrics.data(), 0, quadrics.size() * sizeof(Quadric));
+    for (size_t i = 0; i < current.size(); i += 3) {
+        const glm::vec3 &a = positions[current[i]];
+        glm::vec3 normal = glm::cross(positions[current[i + 1]] - a, positions[current[i + 2]] - a);
+        float length = glm::length(normal);
+        if (length == 0.0f)
+            continue;
+        normal /= length;
+        const float d = -glm::dot(normal, a);
+        for (int k = 0; k < 3; k++)
+            addPlane(quadrics[current[i + k]], normal, d, 0.5f * length);
+    }
+
+    float maxError = 0.0f;
+    for (size_t target : targetTriangleCounts) {
+        while (current.size() / 3 > target) {
+            size_t excess = current.size() / 3 - target;
+            if (collapsePass(positions, locked, quadrics, current, (excess + 1) / 2, maxError) == 0)
+                break; // Everything left is locked or would fold over
+        }
+        out_indices.push_back(current);
+        out_errors.push_back(maxError);
+    }
+}
+
+float simplifyMesh(
+    const std::vector<glm::vec3> &positions,
+    const std::vector<unsigned int> &indices,
+    size_t targetTriangleCount,
+    std::vector<unsigned int> &out_indices
+) {
+    std::vector<std::vector<unsigned int>> chain;
+    std::vector<float> errors;
+    simplifyMeshChain(positions, indices, std::vector<size_t>(1, targetTriangleCount), chain, errors);
+    out_indices.swap(chain[0]);
+    return errors[0];
+}
@@ -0,0 +1,40 @@
+#ifndef MESHSIMPLIFY_HPP
+#define MESHSIMPLIFY_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Quadric-error simplification of an indexed triangle mesh by half-edge
+// collapses: a vertex is merged into one of its neighbours, so no new
+// vertices are made and the simplified triangles index the original vertex
+// arrays (UVs and normals included). Vertices on a boundary, on a seam (their
+// position is shared with another vertex, e.g. across a UV or normal split)
+// or with a non-manifold fan are never removed, so boundaries and seams keep
+// their exact shape and stay closed.
+//
+// Errors are RMS distances, in model units, from a removed vertex's merged
+// area-weighted face planes to where it collapsed to.
+
+// Simplifies down to about each target triangle count in turn (largest
+// first), writing the triangles and the largest collapse error reached at
+// each target. Stops early if no more collapses are allowed; the remaining
+// targets then get the coarsest mesh reached.
+void simplifyMeshChain(
+    const std::vector<glm::vec3> &positions,
+    const std::vector<unsigned int> &indices,
+    const std::vector<size_t> &targetTriangleCounts,
+    std::vector<std::vector<unsigned int>> &out_indices,
+    std::vector<float> &out_errors
+);
+
+// A single target. Returns the largest collapse error.
+float simplifyMesh(
+    const std::vector<glm::vec3> &positions,
+    const std::vector<unsigned int> &indices,
+    size_t targetTriangleCount,
+    std::vector<unsigned int> &out_indices
+);
+
+#endif
@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+#include "meshtopology.hpp"
+#include "threadpool.hpp"
+
+namespace {
+
+const int radixBits = 11;
+const size_t radixBuckets = size_t(1) << radixBits;
+const uint64_t radixMask = radixBuckets - 1;
+const size_t minChunkItems = 16384;
+
+// Fixed split of [0, count) into contiguous chunks. Unlike a bare parallelFor,
+// the chunk boundaries are known up front, so per-chunk partial results can
+// be combined in chunk order and the output never depends on scheduling.
+struct Chunks {
+    size_t count;
+    size_t chunkCount;
+    size_t chunkSize;
+
+    Chunks(size_t count, ThreadPool &pool) : count(count) {
+        chunkCount = std::max<size_t>(1, std::min<size_t>(pool.size() + 1, count / minChunkItems));
+        chunkSize = (count + chunkCount - 1) / chunkCount;
+    }
+    size_t begin(size_t chunk) const { return std::min(count, chunk * chunkSize); }
+    size_t end(size_t chunk) const { return std::min(count, (chunk + 1) * chunkSize); }
+};
+
+void forEachChunk(ThreadPool &pool, const Chunks &chunks, const std::function<void(size_t, size_t, size_t)> &body) {
+    pool.parallelFor(chunks.chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++)
+            body(c, chunks.begin(c), chunks.end(c));
+    });
+}
+
+// Stable LSD radix sort of (key, value) pairs on the low 'keyBits' bits of the keys.
+// Each chunk histograms and scatters its own slice; chunk-major bucket offsets
+// keep the sort stable.
+void radixSortPairs(std::vector<uint64_t> &keys, std::vector<unsigned int> &values, int keyBits, ThreadPool &pool) {
+    const size_t n = keys.size();
+    Chunks chunks(n, pool);
+    std::vector<uint64_t> keysTmp(n);
+    std::vector<unsigned int> valuesTmp(n);
+    std::vector<size_t> counts(chunks.chunkCount * radixBuckets);
+
+    for (int shift = 0; shift < keyBits; shift += radixBits) {
+        forEachChunk(pool, chunks, [&](size_t c, size_t begin, size_t end) {
+            size_t *histogram = &counts[c * radixBuckets];
+            std::fill(histogram, histogram + radixBuckets, 0);
+            for (size_t i = begin; i < end; i++)
+                histogram[(keys[i] >> shift) & radixMask]++;
+        });
+
+        // Skip passes where every key has the same digit
+        bool constantDigit = false;
+        size_t sum = 0;
+        for (size_t d = 0; d < radixBuckets; d++) {
+            size_t bucketStart = sum;
+            for (size_t c = 0; c < chunks.chunkCount; c++) {
+                size_t count = counts[c * radixBuckets + d];
+                counts[c * radixBuckets + d] = sum;
+                sum += count;
+            }
+            if (sum - bucketStart == n)
+                constantDigit = true;
+        }
+        if (constantDigit)
+            continue;
+
+        forEachChunk(pool, chunks, [&](size_t c, size_t begin, size_t end) {
+            size_t *offsets = &counts[c * radixBuckets];
+            for (size_t i = begin; i < end; i++) {
+                size_t slot = offsets[(keys[i] >> shift) & radixMask]++;
+                keysTmp[slot] = keys[i];
+                valuesTmp[slot] = values[i];
+            }
+        });
+        keys.swap(keysTmp);
+        values.swap(valuesTmp);
+    }
+}
+
+int bitsFor(size_t value) {
+    int bits = 1;
+    while (bits < 64 && (uint64_t(1) << bits) <= value)
+        bits++;
+    return bits;
+}
+
+} // namespace
+
+void buildMeshTopology(const std::vector<unsigned int> &indices, size_t vertexCount, MeshTopology &topology) {
+    ThreadPool &pool = ThreadPool::shared();
+    const size_t halfEdgeCount = indices.size() - indices.size() % 3;
+    const int vertexBits = bitsFor(vertexCount);
+    Chunks chunks(halfEdgeCount, pool);
+
+    // One packed (low, high) key per half-edge
+    std::vector<uint64_t> keys(halfEdgeCount);
+    std::vector<unsigned int> halfEdges(halfEdgeCount);
+    forEachChunk(pool, chunks, [&](size_t, size_t begin, size_t end) {
+        for (size_t h = begin; h < end; h++) {
+            unsigned int a = indices[h];
+            unsigned int b = indices[h - h % 3 + (h + 1) % 3];
+            uint64_t low = std::min(a, b), high = std::max(a, b);
+            keys[h] = (low << vertexBits) | high;
+            halfEdges[h] = static_cast<unsigned int>(h);
+        }
+    });
+    radixSortPairs(keys, halfEdges, 2 * vertexBits, pool);
+
+    // Runs of equal keys are the unique edges. Count run heads per chunk
+    // first so every chunk knows the id of its first edge.
+    std::vector<size_t> chunkFirstEdge(chunks.chunkCount + 1, 0);
+    forEachChunk(pool, chunks, [&](size_t c, size_t begin, size_t end) {
+        size_t heads = 0;
+        for (size_t i = begin; i < end; i++)
+            heads += (i == 0 || keys[i] != keys[i - 1]);
+        chunkFirstEdge[c + 1] = heads;
+    });
+    for (size_t c = 0; c < chunks.chunkCount; c++)
+        chunkFirstEdge[c + 1] += chunkFirstEdge[c];
+
+    const size_t edgeCount = chunkFirstEdge[chunks.chunkCount];
+    const uint64_t highMask = (uint64_t(1) << vertexBits) - 1;
+    topology.edgeLow.resize(edgeCount);
+    topology.edgeHigh.resize(edgeCount);
+    topology.edgeHalfEdgeOffsets.resize(edgeCount + 1);
+    topology.halfEdgeEdge.resize(halfEdgeCount);
+    forEachChunk(pool, chunks, [&](size_t c, size_t begin, size_t end) {
+        size_t nextEdge = chunkFirstEdge[c];
+        for (size_t i = begin; i < end; i++) {
+            if (i == 0 || keys[i] != keys[i - 1]) {
+                topology.edgeHalfEdgeOffsets[nextEdge] = static_cast<unsigned int>(i);
+                topology.edgeLow[nextEdge] = static_cast<unsigned int>(keys[i] >> vertexBits);
+                topology.edgeHigh[nextEdge] = static_cast<unsigned int>(keys[i] & highMask);
+                nextEdge++;
+            }
+            topology.halfEdgeEdge[halfEdges[i]] = static_cast<unsigned int>(nextEdge - 1);
+        }
+    });
+    topology.edgeHalfEdgeOffsets[edgeCount] = static_cast<unsigned int>(halfEdgeCount);
+    topology.edgeHalfEdges.swap(halfEdges);
+
+    // Vertex neighbors: every edge adds one entry to each endpoint
+    topology.vertexNeighborOffsets.assign(vertexCount + 1, 0);
+    for (size_t e = 0; e < edgeCount; e++) {
+        topology.vertexNeighborOffsets[topology.edgeLow[e] + 1]++;
+        topology.vertexNeighborOffsets[topology.edgeHigh[e] + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++)
+        topology.vertexNeighborOffsets[v + 1] += topology.vertexNeighborOffsets[v];
+
+    topology.vertexNeighbors.resize(2 * edgeCount);
+    topology.vertexNeighborEdges.resize(2 * edgeCount);
+    std::vector<unsigned int> cursor(topology.vertexNeighborOffsets.begin(), topology.vertexNeighborOffsets.end() - 1);
+
+    // Edges are sorted by (low, high). Filling the smaller neighbors first
+    // (ascending in low), then the larger ones (ascending in high), leaves
+    // every neighbor list sorted without a further sort.
+    for (size_t e = 0; e < edgeCount; e++) {
+        unsigned int slot = cursor[topology.edgeHigh[e]]++;
+        topology.vertexNeighbors[slot] = topology.edgeLow[e];
+        topology.vertexNeighborEdges[slot] = static_cast<unsigned int>(e);
+    }
+    for (size_t e = 0; e < edgeCount; e++) {
+        unsigned int slot = cursor[topology.edgeLow[e]]++;
+        topology.vertexNeighbors[slot] = topology.edgeHigh[e];
+        topology.vertexNeighborEdges[slot] = static_cast<unsigned int>(e);
+    }
+}
+
+void buildVertexCornerTable(const std::vector<unsigned int> &indices, size_t vertexCount, VertexCorners &table) {
+    std::vector<unsigned int> &offsets = table.offsets;
+    std::vector<unsigned int> &corners = table.corners;
+    const size_t cornerCount = indices.size() - indices.size() % 3;
+    offsets.assign(vertexCount + 1, 0);
+    for (size_t c = 0; c < cornerCount; c++)
+        offsets[indices[c] + 1]++;
+    for (size_t v = 0; v < vertexCount; v++)
+        offsets[v + 1] += offsets[v];
+
+    corners.resize(cornerCount);
+    std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t c = 0; c < cornerCount; c++)
+        corners[cursor[indices[c]]++] = static_cast<unsigned int>(c);
+}
+
+int vertexRing(const std::vector<unsigned int> &indices, const VertexCorners &corners, unsigned int v, unsigned int *ring, bool &boundary) {
+    const unsigned int first = corners.offsets[v];
+    const int k = static_cast<int>(corners.offsets[v + 1] - first);
+    if (k == 0 || k >= maxVertexRing)
+        return 0;
+
+    // Face j spans v -> from[j] -> to[j]; k >= 1, so face 0 is always filled
+    unsigned int from[maxVertexRing], to[maxVertexRing];
+    int face = 0;
+    do {
+        const unsigned int c = corners.corners[first + face];
+        from[face] = indices[c - c % 3 + (c + 1) % 3];
+        to[face] = indices[c - c % 3 + (c + 2) % 3];
+        if (from[face] == v || to[face] == v || from[face] == to[face])
+            return 0;
+    } while (++face < k);
+
+    // A boundary fan starts at the one neighbour no face leads to
+    int start = 0, starts = 0;
+    for (int j = 0; j < k; j++) {
+        bool reached = false;
+        for (int i = 0; i < k && !reached; i++)
+            reached = to[i] == from[j];
+        if (!reached) {
+            start = j;
+            starts++;
+        }
+    }
+    if (starts > 1)
+        return 0;
+    boundary = starts == 1;
+
+    int count = 0;
+    ring[count++] = from[start];
+    unsigned int current = to[start];
+    for (int step = 1; step < k; step++) {
+        ring[count++] = current;
+        int next = -1;
+        for (int j = 0; j < k; j++) {
+            if (from[j] == current) {
+                if (next >= 0)
+                    return 0; // Two faces leave the same edge
+                next = j;
+            }
+        }
+        if (next < 0 || next == start)
+            return 0;
+        current = to[next];
+    }
+    // Closed rings come back to where they started, open ones end on the other boundary edge
+    if (boundary) {
+        ring[count++] = current;
+        for (int i = 0; i < count - 1; i++)
+            if (ring[i] == current)
+                return 0;
+    } else if (current != ring[0]) {
+        return 0;
+    }
+    return count;
+}
@@ -0,0 +1,61 @@
+#ifndef MESHTOPOLOGY_HPP
+#define MESHTOPOLOGY_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Flat adjacency tables for an indexed triangle mesh, stored in compressed
+// sparse row (CSR) form: the entries for item i are
+// table[offsets[i] .. offsets[i + 1]).
+//
+// Half-edge h is the edge from corner h to corner h + 1 (wrapping within its
+// triangle) of face h / 3, i.e. indices[h] -> indices[h - h % 3 + (h + 1) % 3].
+struct MeshTopology {
+    // Unique undirected edges, sorted by (smaller, larger) vertex index.
+    std::vector<unsigned int> edgeLow, edgeHigh;
+
+    // Edge -> half-edges lying on it, in face order. One entry means a
+    // boundary edge, two an interior edge, more a non-manifold edge.
+    std::vector<unsigned int> edgeHalfEdgeOffsets;
+    std::vector<unsigned int> edgeHalfEdges;
+
+    // Half-edge -> edge.
+    std::vector<unsigned int> halfEdgeEdge;
+
+    // Vertex -> neighboring vertices in ascending order, with the connecting edge.
+    std::vector<unsigned int> vertexNeighborOffsets;
+    std::vector<unsigned int> vertexNeighbors;
+    std::vector<unsigned int> vertexNeighborEdges;
+
+    size_t edgeCount() const { return edgeLow.size(); }
+    unsigned int edgeFaceCount(size_t edge) const { return edgeHalfEdgeOffsets[edge + 1] - edgeHalfEdgeOffsets[edge]; }
+    bool isBoundaryEdge(size_t edge) const { return edgeFaceCount(edge) == 1; }
+};
+
+// Builds the tables with a radix sort over packed 64-bit edge keys; no per-edge
+// allocation and no comparison-based containers. Large meshes are split across
+// ThreadPool::shared(); the result does not depend on the thread count.
+void buildMeshTopology(const std::vector<unsigned int> &indices, size_t vertexCount, MeshTopology &topology);
+
+// Vertex -> triangle corners that reference it, in ascending corner order
+// (corner c belongs to face c / 3), in the same CSR form. Much cheaper than a
+// full MeshTopology when only per-vertex gathers over faces are needed.
+struct VertexCorners {
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> corners;
+};
+
+void buildVertexCornerTable(const std::vector<unsigned int> &indices, size_t vertexCount, VertexCorners &table);
+
+// Longest one-ring vertexRing handles
+const int maxVertexRing = 64;
+
+// The neighbours of vertex v in counter-clockwise order (as seen from the
+// front side), walking its faces through the corner table. An interior vertex
+// with k faces gets k neighbours; a boundary vertex k + 1, from the boundary
+// edge whose face follows it to the one whose face precedes it. 'ring' needs
+// room for maxVertexRing entries. Returns the neighbour count, or 0 if the
+// faces do not form a single fan (or it is too large).
+int vertexRing(const std::vector<unsigned int> &indices, const VertexCorners &corners, unsigned int v, unsigned int *ring, bool &boundary);
+
+#endif
@@ -2,15 +2,30 @@
 #include <stdio.h>
 #include <string>
 #include <cstring>
-#include <tuple>
-#include <map>
+#include <charconv>
+#include <algorithm>
+#include <chrono>
+#include <limits>
 
 #include <glm/glm.hpp>
 
 #include "objloader.hpp"
+#include "mappedfile.hpp"
+#include "threadpool.hpp"
+#include "tripleindexmap.hpp"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
 
 // Very, VERY simple OBJ loader.
-// Here is a short list of features a real function would provide : 
+// Here is a short list of features a real function would provide :
 // - Binary files. Reading a model should be just a few memcpy's away, not parsing a file at runtime. In short : OBJ is not very great.
 // - Animations & bones (includes bones weights)
 // - Multiple UVs
@@ -18,6 +33,429 @@
 // - More stable. Change a line in the OBJ file and it crashes.
 // - More secure. Change another line and you can inject code.
 // - Loading from memory, stream, etc
+//
+// The file is memory-mapped and walked with a small hand-written tokenizer.
+// Floats go through std::from_chars, which is locale-independent and gives the
+// same correctly rounded values as the old fscanf("%f") path.
+// Large files are cut at line boundaries and the chunks are parsed in parallel,
+// then concatenated in file order, so the result never depends on the thread count.
+
+namespace {
+
+// Don't bother splitting files into chunks smaller than this.
+const size_t minChunkBytes = 1 << 20;
+
+// In low-memory mode, parsed text is dropped from the resident set in steps of this size.
+const size_t discardStepBytes = 16 << 20;
+
+// One face corner, as zero-based indices into the raw attribute pools.
+struct ObjCorner {
+    unsigned int v, vt, vn;
+};
+
+// A corner that used negative (relative) indices. While parsing a chunk these
+// are resolved against the chunk's own record counts and must later be shifted
+// by the number of records in the chunks before it.
+struct RelativeCorner {
+    size_t corner;
+    unsigned char mask; // 1 = v, 2 = vt, 4 = vn
+};
+
+// Raw records of an OBJ file (or chunk of one), before v/vt/vn triples are merged into vertices.
+struct ObjRecords {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjCorner> corners; // Three per triangle
+    std::vector<RelativeCorner> relativeCorners;
+};
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char *skipBlanks(const char *p, const char *end) {
+    while (p < end && isBlank(*p))
+        ++p;
+    return p;
+}
+
+inline const char *nextLine(const char *p, const char *end) {
+    const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+    return eol ? eol + 1 : end;
+}
+
+inline bool parseFloat(const char *&p, const char *end, float &out) {
+    p = skipBlanks(p, end);
+    if (p < end && *p == '+') // from_chars does not accept an explicit plus sign
+        ++p;
+    std::from_chars_result res = std::from_chars(p, end, out);
+    if (res.ec != std::errc())
+        return false;
+    p = res.ptr;
+    return true;
+}
+
+inline bool parseIndex(const char *&p, const char *end, long long &out) {
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        ++p;
+    }
+    const char *start = p;
+    long long value = 0;
+    while (p < end && static_cast<unsigned char>(*p - '0') < 10) {
+        value = value * 10 + (*p - '0');
+        if (value > std::numeric_limits<unsigned int>::max())
+            return false; // No mesh has that many records; also keeps 'value' from overflowing
+        ++p;
+    }
+    if (p == start || value == 0)
+        return false;
+    out = negative ? -value : value;
+    return true;
+}
+
+// Converts a one-based OBJ index to a zero-based one. Negative indices are
+// relative to the records seen so far in this chunk; unsigned wrap-around keeps
+// them correct once the chunk's base offset is added. Range checks happen later,
+// when the whole file is known.
+inline unsigned int resolveIndex(long long index, size_t count, unsigned char bit, unsigned char &mask) {
+    if (index > 0)
+        return static_cast<unsigned int>(index - 1);
+    mask |= bit;
+    return static_cast<unsigned int>(static_cast<long long>(count) + index);
+}
+
+// Parses one "v/vt/vn" face corner.
+inline bool parseCorner(const char *&p, const char *end, const ObjRecords &rec, ObjCorner &corner, unsigned char &mask) {
+    long long v, vt, vn;
+    if (!parseIndex(p, end, v) || p == end || *p++ != '/')
+        return false;
+    if (!parseIndex(p, end, vt) || p == end || *p++ != '/')
+        return false;
+    if (!parseIndex(p, end, vn))
+        return false;
+    mask = 0;
+    corner.v = resolveIndex(v, rec.positions.size(), 1, mask);
+    corner.vt = resolveIndex(vt, rec.uvs.size(), 2, mask);
+    corner.vn = resolveIndex(vn, rec.normals.size(), 4, mask);
+    return true;
+}
+
+inline void pushCorner(ObjRecords &rec, const ObjCorner &corner, unsigned char mask) {
+    if (mask != 0)
+        rec.relativeCorners.push_back({ rec.corners.size(), mask });
+    rec.corners.push_back(corner);
+}
+
+// Parses a face line (after the "f") and fan-triangulates polygons.
+bool parseFace(const char *&p, const char *end, ObjRecords &rec) {
+    ObjCorner first, previous, current;
+    unsigned char firstMask = 0, previousMask = 0, currentMask = 0;
+    int count = 0;
+    while (true) {
+        p = skipBlanks(p, end);
+        if (p == end || *p == '\n' || *p == '#')
+            break;
+        if (!parseCorner(p, end, rec, current, currentMask))
+            return false;
+        if (count >= 2) {
+            pushCorner(rec, first, firstMask);
+            pushCorner(rec, previous, previousMask);
+            pushCorner(rec, current, currentMask);
+        } else if (count == 0) {
+            first = current;
+            firstMask = currentMask;
+        }
+        previous = current;
+        previousMask = currentMask;
+        count++;
+    }
+    return count >= 3;
+}
+
+// Counts the records in [p, end) so the pools can be reserved exactly.
+void countRecords(const char *p, const char *end, const MappedFile &file, size_t &positions, size_t &uvs, size_t &normals, size_t &corners) {
+    positions = uvs = normals = corners = 0;
+    const char *consumed = p;
+    while (p < end) {
+        if (static_cast<size_t>(p - consumed) >= discardStepBytes) {
+            file.discard(consumed, p);
+            consumed = p;
+        }
+
+        p = skipBlanks(p, end);
+        if (p == end)
+            break;
+
+        const char c0 = *p;
+        const char c1 = (p + 1 < end) ? p[1] : '\n';
+        if (c0 == 'v' && isBlank(c1)) {
+            positions++;
+        } else if (c0 == 'v' && c1 == 't' && p + 2 < end && isBlank(p[2])) {
+            uvs++;
+        } else if (c0 == 'v' && c1 == 'n' && p + 2 < end && isBlank(p[2])) {
+            normals++;
+        } else if (c0 == 'f' && isBlank(c1)) {
+            // A polygon with n corners is fanned into n - 2 triangles
+            size_t faceCorners = 0;
+            for (p += 1;;) {
+                p = skipBlanks(p, end);
+                if (p == end || *p == '\n' || *p == '#')
+                    break;
+                faceCorners++;
+                while (p < end && !isBlank(*p) && *p != '\n')
+                    ++p;
+            }
+            if (faceCorners >= 3)
+                corners += 3 * (faceCorners - 2);
+        }
+        if (p < end)
+            p = nextLine(p, end);
+    }
+    file.discard(consumed, end);
+}
+
+// Walks [p, end) line by line and appends every v/vt/vn/f record to rec.
+// In low-memory mode ('countFirst') the pools are reserved up front and the
+// text is released from memory as it is consumed.
+bool parseRecords(const char *p, const char *end, const MappedFile &file, ObjRecords &rec, bool countFirst) {
+    if (countFirst) {
+        size_t positions, uvs, normals, corners;
+        countRecords(p, end, file, positions, uvs, normals, corners);
+        rec.positions.reserve(positions);
+        rec.uvs.reserve(uvs);
+        rec.normals.reserve(normals);
+        rec.corners.reserve(corners);
+    }
+
+    const char *consumed = p;
+    while (p < end) {
+        if (countFirst && static_cast<size_t>(p - consumed) >= discardStepBytes) {
+            file.discard(consumed, p);
+            consumed = p;
+        }
+
+        p = skipBlanks(p, end);
+        if (p == end)
+            break;
+
+        const char c0 = *p;
+        const char c1 = (p + 1 < end) ? p[1] : '\n';
+        if (c0 == 'v' && isBlank(c1)) {
+            p += 1;
+            glm::vec3 vertex;
+            if (!parseFloat(p, end, vertex.x) || !parseFloat(p, end, vertex.y) || !parseFloat(p, end, vertex.z))
+                return false;
+            rec.positions.push_back(vertex);
+        } else if (c0 == 'v' && c1 == 't' && p + 2 < end && isBlank(p[2])) {
+            p += 2;
+            glm::vec2 uv;
+            if (!parseFloat(p, end, uv.x) || !parseFloat(p, end, uv.y))
+                return false;
+            uv.y = -uv.y; // Invert V coordinate
+            rec.uvs.push_back(uv);
+        } else if (c0 == 'v' && c1 == 'n' && p + 2 < end && isBlank(p[2])) {
+            p += 2;
+            glm::vec3 normal;
+            if (!parseFloat(p, end, normal.x) || !parseFloat(p, end, normal.y) || !parseFloat(p, end, normal.z))
+                return false;
+            rec.normals.push_back(normal);
+        } else if (c0 == 'f' && isBlank(c1)) {
+            p += 1;
+            if (!parseFace(p, end, rec))
+                return false;
+        }
+        // Comments, groups, materials and any unparsed tail of the line are skipped
+        if (p < end)
+            p = nextLine(p, end);
+    }
+    if (countFirst)
+        file.discard(consumed, end);
+    return true;
+}
+
+// Splits [begin, end) into at most maxChunks pieces that each end on a line boundary.
+std::vector<const char *> splitAtLines(const char *begin, const char *end, size_t maxChunks) {
+    std::vector<const char *> bounds;
+    bounds.push_back(begin);
+    size_t total = static_cast<size_t>(end - begin);
+    for (size_t i = 1; i < maxChunks; i++) {
+        const char *cut = begin + total * i / maxChunks;
+        if (cut <= bounds.back())
+            continue;
+        cut = nextLine(cut, end);
+        if (cut > bounds.back() && cut < end)
+            bounds.push_back(cut);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
+
+// Parses the chunks in parallel and concatenates them, in file order, into rec.
+bool parseRecordsParallel(const std::vector<const char *> &bounds, const MappedFile &file, ObjRecords &rec, bool countFirst) {
+    const size_t chunkCount = bounds.size() - 1;
+    std::vector<ObjRecords> chunks(chunkCount);
+    std::vector<char> ok(chunkCount, 0);
+
+    ThreadPool &pool = ThreadPool::shared();
+    pool.parallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++)
+            ok[c] = parseRecords(bounds[c], bounds[c + 1], file, chunks[c], countFirst);
+    });
+    if (std::find(ok.begin(), ok.end(), 0) != ok.end())
+        return false;
+
+    // Prefix sums give every chunk its offset in the merged pools
+    struct ChunkBase { size_t position, uv, normal, corner; };
+    std::vector<ChunkBase> bases(chunkCount);
+    ChunkBase total = { 0, 0, 0, 0 };
+    for (size_t c = 0; c < chunkCount; c++) {
+        bases[c] = total;
+        total.position += chunks[c].positions.size();
+        total.uv += chunks[c].uvs.size();
+        total.normal += chunks[c].normals.size();
+        total.corner += chunks[c].corners.size();
+    }
+    rec.positions.resize(total.position);
+    rec.uvs.resize(total.uv);
+    rec.normals.resize(total.normal);
+    rec.corners.resize(total.corner);
+
+    pool.parallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++) {
+            ObjRecords &chunk = chunks[c];
+            const ChunkBase &base = bases[c];
+            for (const RelativeCorner &rel : chunk.relativeCorners) {
+                ObjCorner &corner = chunk.corners[rel.corner];
+                if (rel.mask & 1) corner.v += static_cast<unsigned int>(base.position);
+                if (rel.mask & 2) corner.vt += static_cast<unsigned int>(base.uv);
+                if (rel.mask & 4) corner.vn += static_cast<unsigned int>(base.normal);
+            }
+            std::copy(chunk.positions.begin(), chunk.positions.end(), rec.positions.begin() + base.position);
+            std::copy(chunk.uvs.begin(), chunk.uvs.end(), rec.uvs.begin() + base.uv);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), rec.normals.begin() + base.normal);
+            std::copy(chunk.corners.begin(), chunk.corners.end(), rec.corners.begin() + base.corner);
+            chunk = ObjRecords(); // Release the chunk as soon as it has been merged
+        }
+    });
+    return true;
+}
+
+// Merges identical v/vt/vn triples into single output vertices, in order of first use.
+// Fails if a face refers to a record that does not exist.
+bool buildIndexedMesh(
+    const ObjRecords &rec,
+    std::vector<glm::vec3> &out_vertices,
+    std::vector<glm::vec2> &out_uvs,
+    std::vector<glm::vec3> &out_normals,
+    std::vector<unsigned int> &out_indices
+) {
+    // Initial capacity only: a closed triangle mesh has about half as many
+    // vertices as faces, plus some for UV and normal seams. Triangle soup can
+    // reach three per face; the map grows when it needs to.
+    TripleIndexMap indexMap(rec.corners.size() / 3);
+
+    const size_t positionCount = rec.positions.size();
+    const size_t uvCount = rec.uvs.size();
+    const size_t normalCount = rec.normals.size();
+
+    out_indices.reserve(out_indices.size() + rec.corners.size());
+    for (const ObjCorner &corner : rec.corners) {
+        if (corner.v >= positionCount || corner.vt >= uvCount || corner.vn >= normalCount)
+            return false;
+
+        // Look up the vertex/UV/normal combination, assigning the next index if it is new
+        bool inserted;
+        unsigned int newIndex = static_cast<unsigned int>(out_vertices.size());
+        unsigned int index = indexMap.findOrInsert(corner.v, corner.vt, corner.vn, newIndex, inserted);
+        if (inserted) {
+            // Add new vertex, UV, and normal to the output vectors
+            out_vertices.push_back(rec.positions[corner.v]);
+            out_uvs.push_back(rec.uvs[corner.vt]);
+            out_normals.push_back(rec.normals[corner.vn]);
+        }
+        out_indices.push_back(index);
+    }
+    return true;
+}
+
+// Same result as buildIndexedMesh, but keeps peak memory down: the corner
+// list, the hash table and each raw attribute pool are freed as soon as they
+// are no longer needed, and every output array is reserved to its exact size.
+bool buildIndexedMeshCompact(
+    ObjRecords &rec,
+    std::vector<glm::vec3> &out_vertices,
+    std::vector<glm::vec2> &out_uvs,
+    std::vector<glm::vec3> &out_normals,
+    std::vector<unsigned int> &out_indices
+) {
+    const size_t positionCount = rec.positions.size();
+    const size_t uvCount = rec.uvs.size();
+    const size_t normalCount = rec.normals.size();
+    const unsigned int base = static_cast<unsigned int>(out_vertices.size());
+
+    // Pass 1: number the unique corners and emit the index buffer
+    std::vector<ObjCorner> uniqueCorners;
+    {
+        TripleIndexMap indexMap(rec.corners.size() / 3);
+        out_indices.reserve(out_indices.size() + rec.corners.size());
+        for (const ObjCorner &corner : rec.corners) {
+            if (corner.v >= positionCount || corner.vt >= uvCount || corner.vn >= normalCount)
+                return false;
+
+            bool inserted;
+            unsigned int newIndex = static_cast<unsigned int>(uniqueCorners.size());
+            unsigned int index = indexMap.findOrInsert(corner.v, corner.vt, corner.vn, newIndex, inserted);
+            if (inserted)
+                uniqueCorners.push_back(corner);
+            out_indices.push_back(base + index);
+        }
+    }
+    std::vector<ObjCorner>().swap(rec.corners);
+
+    // Pass 2: gather one attribute at a time, dropping each source pool right after
+    out_vertices.reserve(out_vertices.size() + uniqueCorners.size());
+    for (const ObjCorner &corner : uniqueCorners)
+        out_vertices.push_back(rec.positions[corner.v]);
+    std::vector<glm::vec3>().swap(rec.positions);
+
+    out_uvs.reserve(out_uvs.size() + uniqueCorners.size());
+    for (const ObjCorner &corner : uniqueCorners)
+        out_uvs.push_back(rec.uvs[corner.vt]);
+    std::vector<glm::vec2>().swap(rec.uvs);
+
+    out_normals.reserve(out_normals.size() + uniqueCorners.size());
+    for (const ObjCorner &corner : uniqueCorners)
+        out_normals.push_back(rec.normals[corner.vn]);
+    std::vector<glm::vec3>().swap(rec.normals);
+    return true;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+size_t getPeakRSS() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return static_cast<size_t>(counters.PeakWorkingSetSize);
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss); // Bytes on macOS
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024; // Kilobytes on Linux
+#endif
+#endif
+}
 
 bool loadOBJ(
     const char *path,
@@ -26,81 +464,67 @@ bool loadOBJ(
     std::vector<glm::vec3> &out_normals,
     std::vector<unsigned int> &out_indices
 ) {
-    printf("Loading OBJ file %s...\n", path);
+    return loadOBJ(path, out_vertices, out_uvs, out_normals, out_indices, OBJLoadOptions());
+}
 
-    std::vector<glm::vec3> temp_vertices;
-    std::vector<glm::vec2> temp_uvs;
-    std::vector<glm::vec3> temp_normals;
-    std::map<std::tuple<unsigned int, unsigned int, unsigned int>, unsigned int> indexMap;
+bool loadOBJ(
+    const char *path,
+    std::vector<glm::vec3> &out_vertices,
+    std::vector<glm::vec2> &out_uvs,
+    std::vector<glm::vec3> &out_normals,
+    std::vector<unsigned int> &out_indices,
+    const OBJLoadOptions &options
+) {
+    printf("Loading OBJ file %s...\n", path);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-    FILE *file = fopen(path, "r");
-    if (file == NULL) {
+    MappedFile file;
+    if (!file.open(path)) {
         printf("Impossible to open the file! Are you in the right path? See Tutorial 1 for details.\n");
         getchar();
         return false;
     }
 
-    while (1) {
-        char lineHeader[128];
-        int res = fscanf(file, "%s", lineHeader);
-        if (res == EOF)
-            break;
+    const char *begin = file.data();
+    const char *end = begin + file.size();
 
-        if (strcmp(lineHeader, "v") == 0) {
-            glm::vec3 vertex;
-            fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
-            temp_vertices.push_back(vertex);
-        } else if (strcmp(lineHeader, "vt") == 0) {
-            glm::vec2 uv;
-            fscanf(file, "%f %f\n", &uv.x, &uv.y);
-            uv.y = -uv.y; // Invert V coordinate
-            temp_uvs.push_back(uv);
-        } else if (strcmp(lineHeader, "vn") == 0) {
-            glm::vec3 normal;
-            fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
-            temp_normals.push_back(normal);
-        } else if (strcmp(lineHeader, "f") == 0) {
-            unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-            int matches = fscanf(
-                file,
-                "%d/%d/%d %d/%d/%d %d/%d/%d\n",
-                &vertexIndex[0], &uvIndex[0], &normalIndex[0],
-                &vertexIndex[1], &uvIndex[1], &normalIndex[1],
-                &vertexIndex[2], &uvIndex[2], &normalIndex[2]
-            );
-
-            if (matches != 9) {
-                printf("File can't be read by our simple parser. Try exporting with other options.\n");
-                fclose(file);
-                return false;
-            }
+    size_t threads = options.threads != 0 ? options.threads : ThreadPool::shared().size() + 1;
+    threads = std::min(threads, std::max<size_t>(1, file.size() / minChunkBytes));
 
-            for (int i = 0; i < 3; i++) {
-                // Create a tuple for the vertex/UV/normal combination
-                auto key = std::make_tuple(vertexIndex[i] - 1, uvIndex[i] - 1, normalIndex[i] - 1);
-
-                // Check if the combination already exists
-                if (indexMap.find(key) == indexMap.end()) {
-                    // Add new vertex, UV, and normal to the output vectors
-                    out_vertices.push_back(temp_vertices[std::get<0>(key)]);
-                    out_uvs.push_back(temp_uvs[std::get<1>(key)]);
-                    out_normals.push_back(temp_normals[std::get<2>(key)]);
-
-                    // Assign a new index for this combination
-                    unsigned int newIndex = static_cast<unsigned int>(out_vertices.size() - 1);
-                    indexMap[key] = newIndex;
-                    out_indices.push_back(newIndex);
-                } else {
-                    // Use the existing index
-                    out_indices.push_back(indexMap[key]);
-                }
-            }
-        } else {
-            char stupidBuffer[1000];
-            fgets(stupidBuffer, 1000, file);
-        }
+    ObjRecords rec;
+    bool parsed;
+    if (threads > 1)
+        parsed = parseRecordsParallel(splitAtLines(begin, end, threads), file, rec, options.countRecordsFirst);
+    else
+        parsed = parseRecords(begin, end, file, rec, options.countRecordsFirst);
+    if (!parsed) {
+        printf("File can't be read by our simple parser. Try exporting with other options.\n");
+        return false;
+    }
+    file.close();
+
+    if (options.stats) {
+        options.stats->positions = rec.positions.size();
+        options.stats->uvs = rec.uvs.size();
+        options.stats->normals = rec.normals.size();
+        options.stats->triangles = rec.corners.size() / 3;
+        options.stats->parseSeconds = secondsSince(start);
+        start = std::chrono::steady_clock::now();
     }
 
-    fclose(file);
+    bool indexed;
+    if (options.countRecordsFirst)
+        indexed = buildIndexedMeshCompact(rec, out_vertices, out_uvs, out_normals, out_indices);
+    else
+        indexed = buildIndexedMesh(rec, out_vertices, out_uvs, out_normals, out_indices);
+    if (!indexed) {
+        printf("File can't be read by our simple parser. Try exporting with other options.\n");
+        return false;
+    }
+
+    if (options.stats) {
+        options.stats->indexSeconds = secondsSince(start);
+        options.stats->peakRSSBytes = getPeakRSS();
+    }
     return true;
 }
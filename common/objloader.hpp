@@ -1,6 +1,33 @@
 #ifndef OBJLOADER_H
 #define OBJLOADER_H
 
+#include <cstddef>
+
+// Filled in by loadOBJ when OBJLoadOptions::stats is set.
+struct OBJLoadStats {
+    size_t positions = 0, uvs = 0, normals = 0, triangles = 0; // Records in the file
+    double parseSeconds = 0.0;   // Mapping and tokenizing
+    double indexSeconds = 0.0;   // Merging v/vt/vn triples into output vertices
+    size_t peakRSSBytes = 0;     // Process peak resident set size after loading (0 if unknown)
+};
+
+// Tuning knobs for loadOBJ. Every setting produces the same mesh, bit for bit.
+struct OBJLoadOptions {
+    // Threads used to parse records. 0 picks one per hardware thread;
+    // small files are always parsed on the calling thread.
+    unsigned int threads = 0;
+
+    // Low-memory mode: pre-scan the file to reserve exact pool capacities
+    // instead of growing them, and free each raw attribute pool as soon as
+    // its values have been copied to the output.
+    bool countRecordsFirst = false;
+
+    OBJLoadStats *stats = nullptr;
+};
+
+// Peak resident set size of this process so far, in bytes (0 if unknown).
+size_t getPeakRSS();
+
 bool loadOBJ(
     const char *path,
     std::vector<glm::vec3> &out_vertices,
@@ -9,4 +36,13 @@ bool loadOBJ(
     std::vector<unsigned int> &out_indices
 );
 
+bool loadOBJ(
+    const char *path,
+    std::vector<glm::vec3> &out_vertices,
+    std::vector<glm::vec2> &out_uvs,
+    std::vector<glm::vec3> &out_normals,
+    std::vector<unsigned int> &out_indices,
+    const OBJLoadOptions &options
+);
+
 #endif
@@ -0,0 +1,131 @@
+#include <algorithm>
+
+#include "renderqueue.hpp"
+
+void RenderState::reset() {
+    program = texture = vertexArray = mode = unknown;
+    activeTextureSet = false;
+}
+
+// Records the new binding; false (and counted as skipped) if it is already bound
+bool RenderState::changed(GLuint &bound, GLuint value) {
+    if (bound == value) {
+        skipped++;
+        return false;
+    }
+    bound = value;
+    issued++;
+    return true;
+}
+
+void RenderState::useProgram(GLuint value) {
+    if (changed(program, value))
+        glUseProgram(value);
+}
+
+void RenderState::bindTexture(GLuint value) {
+    if (!activeTextureSet) {
+        glActiveTexture(GL_TEXTURE0);
+        activeTextureSet = true;
+    }
+    if (changed(texture, value))
+        glBindTexture(GL_TEXTURE_2D, value);
+}
+
+void RenderState::bindVertexArray(GLuint value) {
+    if (changed(vertexArray, value))
+        glBindVertexArray(value);
+}
+
+void RenderState::polygonMode(GLenum value) {
+    if (changed(mode, value))
+        glPolygonMode(GL_FRONT_AND_BACK, value);
+}
+
+uint64_t RenderQueue::sortKey(const DrawItem &item) {
+    uint64_t wireframe = (item.polygonMode != GL_FILL) ? 1 : 0;
+    uint64_t program = item.program ? (item.program->id() & 0xFFFF) : 0;
+    uint64_t texture = item.texture & 0xFFFF;
+    uint64_t vertexArray = item.vertexArray & 0xFFFF;
+    float depth = std::min(std::max(0.5f * item.depth + 0.5f, 0.0f), 1.0f);
+    uint64_t depthBits = static_cast<uint64_t>(depth * 32767.0f);
+    return (wireframe << 63) | (program << 47) | (texture << 31) | (vertexArray << 15) | depthBits;
+}
+
+void RenderQueue::submit(const DrawItem &item) {
+    order.push_back(std::make_pair(sortKey(item), static_cast<uint32_t>(items.size())));
+    items.push_back(item);
+}
+
+bool RenderQueue::batchable(const DrawItem &a, const DrawItem &b) {
+    if (a.program != b.program || a.texture != b.texture || a.vertexArray != b.vertexArray)
+        return false;
+    if (a.polygonMode != b.polygonMode || a.primitive != b.primitive || a.mvpHandle != b.mvpHandle || a.mvp != b.mvp)
+        return false;
+    for (size_t i = 0; i < 2; i++) {
+        if (a.integers[i].handle != b.integers[i].handle || a.integers[i].value != b.integers[i].value)
+            return false;
+    }
+    return true;
+}
+
+// Sets the state and uniforms 'item' needs
+void RenderQueue::apply(const DrawItem &item, RenderState &state) {
+    ShaderProgram &program = *item.program;
+    state.useProgram(program.id());
+    program.set(item.mvpHandle, item.mvp);
+    for (const DrawItem::IntUniform &u : item.integers)
+        program.set(u.handle, u.value);
+    if (item.texture != 0)
+        state.bindTexture(item.texture);
+    state.polygonMode(item.polygonMode);
+    state.bindVertexArray(item.vertexArray);
+}
+
+void RenderQueue::execute(const DrawItem &item, RenderState &state) {
+    apply(item, state);
+    glDrawElementsBaseVertex(item.primitive, item.count, GL_UNSIGNED_INT,
+                             reinterpret_cast<const void *>(size_t(item.firstIndex) * sizeof(unsigned int)), item.baseVertex);
+}
+
+RenderStats RenderQueue::flush(RenderState &state) {
+    // Whatever ran since the last flush may have changed the bindings
+    state.reset();
+    size_t issuedBefore = state.issuedCount(), skippedBefore = state.skippedCount();
+
+    RenderStats stats;
+    std::sort(order.begin(), order.end());
+    for (size_t first = 0; first < order.size();) {
+        const DrawItem &item = items[order[first].second];
+        size_t last = first + 1;
+        while (last < order.size() && batchable(item, items[order[last].second]))
+            last++;
+
+        if (last - first == 1) {
+            execute(item, state);
+        } else {
+            counts.clear();
+            offsets.clear();
+            baseVertices.clear();
+            for (size_t i = first; i < last; i++) {
+                const DrawItem &part = items[order[i].second];
+                counts.push_back(part.count);
+                offsets.push_back(reinterpret_cast<const void *>(size_t(part.firstIndex) * sizeof(unsigned int)));
+                baseVertices.push_back(part.baseVertex);
+            }
+            apply(item, state);
+            glMultiDrawElementsBaseVertex(item.primitive, counts.data(), GL_UNSIGNED_INT, offsets.data(),
+                                          static_cast<GLsizei>(counts.size()), baseVertices.data());
+        }
+        stats.batches++;
+        first = last;
+    }
+    state.polygonMode(GL_FILL);
+
+    stats.draws = items.size();
+    stats.stateCalls = state.issuedCount() - issuedBefore;
+    stats.skippedCalls = state.skippedCount() - skippedBefore;
+    items.clear();
+    order.clear();
+    return stats;
+}
@@ -0,0 +1,111 @@
+#ifndef RENDERQUEUE_HPP
+#define RENDERQUEUE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "shaderprogram.hpp"
+
+// The GL bindings draws change, as last set through this object. A call
+// that would set what is already bound is skipped and counted. State set
+// behind its back (texture uploads, VAO setup, ...) makes it wrong, so call
+// reset() after such code; RenderQueue::flush does at its start.
+//
+// GL thread only. Textures are bound to GL_TEXTURE_2D on unit 0.
+class RenderState {
+public:
+    RenderState() { reset(); }
+
+    // Forgets the bindings: the next call of each kind goes through
+    void reset();
+
+    void useProgram(GLuint program);
+    void bindTexture(GLuint texture);
+    void bindVertexArray(GLuint vertexArray);
+    void polygonMode(GLenum mode); // For GL_FRONT_AND_BACK
+
+    // Calls made and skipped since construction
+    size_t issuedCount() const { return issued; }
+    size_t skippedCount() const { return skipped; }
+
+private:
+    static const GLuint unknown = 0xFFFFFFFFu; // Not a name GL hands out
+
+    bool changed(GLuint &bound, GLuint value);
+
+    GLuint program, texture, vertexArray, mode; // 'unknown' until set
+    bool activeTextureSet;
+    size_t issued = 0, skipped = 0;
+};
+
+// One indexed draw and the state it needs. The uniforms are set through the
+// program's handles, so values it already has are not uploaded again.
+struct DrawItem {
+    struct IntUniform {
+        int handle = -1;
+        int value = 0;
+    };
+
+    ShaderProgram *program = nullptr; // Must outlive the flush
+    GLuint texture = 0;               // 0 leaves the binding alone
+    GLuint vertexArray = 0;           // Its element buffer holds unsigned ints
+    GLenum polygonMode = GL_FILL;
+    GLenum primitive = GL_TRIANGLES;
+    GLsizei count = 0;
+    unsigned int firstIndex = 0;      // Into the element buffer
+    GLint baseVertex = 0;             // Added to every index
+    float depth = 0.0f;               // NDC depth of the object, for front-to-back order
+
+    int mvpHandle = -1;
+    glm::mat4 mvp;
+    IntUniform integers[2];           // E.g. a sampler unit and a toggle
+};
+
+struct RenderStats {
+    size_t draws = 0;        // Items submitted
+    size_t batches = 0;      // GL draw calls they took
+    size_t stateCalls = 0;   // Binding calls issued
+    size_t skippedCalls = 0; // Binding calls avoided because the state matched
+};
+
+// Draws gathered over a frame and submitted in state order. Items are sorted
+// on a 64-bit key: polygon mode, then program, texture and vertex array (the
+// low 16 bits of each name), then depth, so objects sharing state are drawn
+// together, nearest first, and each binding changes as rarely as possible.
+// Neighbours that need exactly the same state and uniforms (e.g. meshes in
+// one GeometryArena block that share a transform) are drawn with a single
+// glMultiDrawElementsBaseVertex.
+class RenderQueue {
+public:
+    void submit(const DrawItem &item);
+
+    // Sorts and draws everything submitted, then empties the queue. Leaves
+    // the last program, texture and VAO bound and the polygon mode GL_FILL.
+    RenderStats flush(RenderState &state);
+
+    size_t size() const { return items.size(); }
+
+    // Draws one item right away through 'state'
+    static void execute(const DrawItem &item, RenderState &state);
+
+    static uint64_t sortKey(const DrawItem &item);
+
+    // True if 'b' can be drawn in the same call as 'a'
+    static bool batchable(const DrawItem &a, const DrawItem &b);
+
+private:
+    static void apply(const DrawItem &item, RenderState &state);
+
+    std::vector<DrawItem> items;
+    std::vector<GLsizei> counts; // Scratch for the multi-draw calls
+    std::vector<const void *> offsets;
+    std::vector<GLint> baseVertices;
+    std::vector<std::pair<uint64_t, uint32_t>> order; // Key and item index
+};
+
+#endif
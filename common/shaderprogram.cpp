@@ -0,0 +1,124 @@
+#include <cstring>
+
+#include "shaderprogram.hpp"
+#include "shader.hpp"
+
+ShaderProgram::~ShaderProgram() {
+    release();
+}
+
+bool ShaderProgram::load(const char *vertexPath, const char *fragmentPath) {
+    release();
+    GLuint linked = LoadShaders(vertexPath, fragmentPath);
+    if (linked == 0)
+        return false;
+    GLint status = GL_FALSE;
+    glGetProgramiv(linked, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        glDeleteProgram(linked);
+        return false;
+    }
+    program = linked;
+
+    // Active uniforms; their values start unknown, so the first set always uploads
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> name(maxLength + 1);
+    for (GLint i = 0; i < count; i++) {
+        Uniform u;
+        GLsizei length = 0;
+        glGetActiveUniform(program, i, maxLength, &length, &u.size, &u.type, name.data());
+        std::string uniformName(name.data(), length);
+        u.location = glGetUniformLocation(program, uniformName.c_str());
+        if (u.location < 0)
+            continue; // In a uniform block
+        u.known = false;
+        memset(u.value, 0, sizeof(u.value));
+        int handle = static_cast<int>(uniforms.size());
+        uniforms.push_back(u);
+        uniformHandles[uniformName] = handle;
+        if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+            uniformHandles[uniformName.substr(0, uniformName.size() - 3)] = handle;
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+    name.resize(maxLength + 1);
+    for (GLint i = 0; i < count; i++) {
+        GLint size = 0;
+        GLenum type = 0;
+        GLsizei length = 0;
+        glGetActiveAttrib(program, i, maxLength, &length, &size, &type, name.data());
+        std::string attributeName(name.data(), length);
+        attributeLocations[attributeName] = glGetAttribLocation(program, attributeName.c_str());
+    }
+    return true;
+}
+
+void ShaderProgram::release() {
+    if (program != 0)
+        glDeleteProgram(program);
+    program = 0;
+    uniforms.clear();
+    uniformHandles.clear();
+    attributeLocations.clear();
+    uploads = skipped = 0;
+}
+
+int ShaderProgram::uniform(const char *name) const {
+    auto it = uniformHandles.find(name);
+    return (it != uniformHandles.end()) ? it->second : -1;
+}
+
+GLint ShaderProgram::attribute(const char *name) const {
+    auto it = attributeLocations.find(name);
+    return (it != attributeLocations.end()) ? it->second : -1;
+}
+
+// Records the new value; false if the program already has it
+bool ShaderProgram::changed(Uniform &u, const void *data, size_t bytes) {
+    if (u.known && memcmp(u.value, data, bytes) == 0) {
+        skipped++;
+        return false;
+    }
+    memcpy(u.value, data, bytes);
+    u.known = true;
+    uploads++;
+    return true;
+}
+
+void ShaderProgram::set(int handle, int value) {
+    if (handle < 0) return;
+    Uniform &u = uniforms[handle];
+    if (changed(u, &value, sizeof(value)))
+        glUniform1i(u.location, value);
+}
+
+void ShaderProgram::set(int handle, float value) {
+    if (handle < 0) return;
+    Uniform &u = uniforms[handle];
+    if (changed(u, &value, sizeof(value)))
+        glUniform1f(u.location, value);
+}
+
+void ShaderProgram::set(int handle, const glm::vec3 &value) {
+    if (handle < 0) return;
+    Uniform &u = uniforms[handle];
+    if (changed(u, &value.x, sizeof(value)))
+        glUniform3fv(u.location, 1, &value.x);
+}
+
+void ShaderProgram::set(int handle, const glm::vec4 &value) {
+    if (handle < 0) return;
+    Uniform &u = uniforms[handle];
+    if (changed(u, &value.x, sizeof(value)))
+        glUniform4fv(u.location, 1, &value.x);
+}
+
+void ShaderProgram::set(int handle, const glm::mat4 &value) {
+    if (handle < 0) return;
+    Uniform &u = uniforms[handle];
+    if (changed(u, &value[0][0], sizeof(value)))
+        glUniformMatrix4fv(u.location, 1, GL_FALSE, &value[0][0]);
+}
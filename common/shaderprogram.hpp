@@ -0,0 +1,71 @@
+#ifndef SHADERPROGRAM_HPP
+#define SHADERPROGRAM_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// A linked GLSL program (built by LoadShaders) together with its active
+// uniforms and attributes, read back once at link time. Uniforms are looked
+// up by name in a hash table and then set through the returned handle, so a
+// draw costs no driver string lookups. Each uniform keeps the value last set
+// through the handle, and setting the same value again uploads nothing.
+//
+// GL thread only. OpenGL 3.3 has no glProgramUniform, so the setters upload
+// into the program that is in use: call use() first.
+class ShaderProgram {
+public:
+    ShaderProgram() {}
+    ~ShaderProgram();
+
+    ShaderProgram(const ShaderProgram &) = delete;
+    ShaderProgram &operator=(const ShaderProgram &) = delete;
+
+    // Compiles, links and reflects. Returns false (and stays empty) on failure.
+    bool load(const char *vertexPath, const char *fragmentPath);
+    void release();
+
+    bool valid() const { return program != 0; }
+    GLuint id() const { return program; }
+    void use() const { glUseProgram(program); }
+
+    // Handle of an active uniform, or -1 if the program has none by that name
+    // (setting -1 does nothing, like location -1 in GL). Array uniforms are
+    // found by their plain name and by "name[0]".
+    int uniform(const char *name) const;
+
+    // Location of an active vertex attribute, or -1.
+    GLint attribute(const char *name) const;
+
+    void set(int handle, int value);
+    void set(int handle, float value);
+    void set(int handle, const glm::vec3 &value);
+    void set(int handle, const glm::vec4 &value);
+    void set(int handle, const glm::mat4 &value);
+
+    // Uploads made and skipped as redundant since load
+    size_t uploadCount() const { return uploads; }
+    size_t skippedCount() const { return skipped; }
+
+private:
+    struct Uniform {
+        GLint location;
+        GLenum type;
+        GLint size;        // Array length
+        bool known;        // Whether 'value' holds what the program has
+        float value[16];   // Last value set (ints stored bitwise)
+    };
+
+    bool changed(Uniform &u, const void *data, size_t bytes);
+
+    GLuint program = 0;
+    std::vector<Uniform> uniforms;
+    std::unordered_map<std::string, int> uniformHandles;
+    std::unordered_map<std::string, GLint> attributeLocations;
+    size_t uploads = 0, skipped = 0;
+};
+
+#endif
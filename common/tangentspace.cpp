@@ -1,7 +1,12 @@
 #include <vector>
+#include <cmath>
 #include <glm/glm.hpp>
 
 #include "tangentspace.hpp"
+#include "meshtopology.hpp"
+#include "threadpool.hpp"
+
+static const size_t grain = 8192;
 
 void computeTangentBasis(
 	// inputs
@@ -70,4 +75,76 @@ void computeTangentBasis(
 
 }
 
+void computeTangentBasis(
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	const std::vector<unsigned int> & indices,
+	std::vector<glm::vec4> & tangents
+){
+	VertexCorners corners;
+	buildVertexCornerTable(indices, vertices.size(), corners);
+	computeTangentBasis(vertices, uvs, normals, indices, corners, tangents);
+}
 
+void computeTangentBasis(
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	const std::vector<unsigned int> & indices,
+	const VertexCorners & corners,
+	std::vector<glm::vec4> & tangents
+){
+	ThreadPool & pool = ThreadPool::shared();
+	const size_t faceCount = indices.size() / 3;
+
+	// Pass 1: the same per-face tangent and bitangent as above, one face each
+	std::vector<glm::vec3> faceTangents(faceCount), faceBitangents(faceCount);
+	pool.parallelFor(faceCount, grain, [&](size_t begin, size_t end){
+		for (size_t f=begin; f<end; f++){
+			const unsigned int i0 = indices[3*f], i1 = indices[3*f+1], i2 = indices[3*f+2];
+			glm::vec3 deltaPos1 = vertices[i1]-vertices[i0];
+			glm::vec3 deltaPos2 = vertices[i2]-vertices[i0];
+			glm::vec2 deltaUV1 = uvs[i1]-uvs[i0];
+			glm::vec2 deltaUV2 = uvs[i2]-uvs[i0];
+
+			float det = deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x;
+			if (det == 0.0f || !std::isfinite(det)){
+				faceTangents[f] = faceBitangents[f] = glm::vec3(0.0f);
+				continue;
+			}
+			float r = 1.0f / det;
+			faceTangents[f] = (deltaPos1 * deltaUV2.y   - deltaPos2 * deltaUV1.y)*r;
+			faceBitangents[f] = (deltaPos2 * deltaUV1.x   - deltaPos1 * deltaUV2.x)*r;
+		}
+	});
+
+	// Pass 2: every vertex sums its own faces, then Gram-Schmidt against its normal
+	tangents.resize(vertices.size());
+	pool.parallelFor(vertices.size(), grain, [&](size_t begin, size_t end){
+		for (size_t v=begin; v<end; v++){
+			glm::vec3 t(0.0f), b(0.0f);
+			for (unsigned int j=corners.offsets[v]; j<corners.offsets[v+1]; j++){
+				t += faceTangents[corners.corners[j] / 3];
+				b += faceBitangents[corners.corners[j] / 3];
+			}
+
+			const glm::vec3 & n = normals[v];
+			t -= n * glm::dot(n, t);
+			float length = glm::length(t);
+			if (length > 0.0f && std::isfinite(length)){
+				t /= length;
+			}else{
+				// Any direction in the tangent plane
+				glm::vec3 axis = (std::fabs(n.x) < 0.9f) ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+				glm::vec3 side = glm::cross(axis, n);
+				float sideLength = glm::length(side);
+				t = (sideLength > 0.0f) ? side / sideLength : axis;
+			}
+
+			// Handedness: whether the UV bitangent agrees with cross(n, t)
+			float w = (glm::dot(glm::cross(n, t), b) < 0.0f) ? -1.0f : 1.0f;
+			tangents[v] = glm::vec4(t, w);
+		}
+	});
+}
@@ -1,6 +1,14 @@
 #ifndef TANGENTSPACE_HPP
 #define TANGENTSPACE_HPP
 
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "meshtopology.hpp"
+
+// Non-indexed: one tangent and bitangent per corner of a triangle soup
+// (vertices taken in triples), to be merged by indexVBO_TBN.
 void computeTangentBasis(
 	// inputs
 	std::vector<glm::vec3> & vertices,
@@ -11,5 +19,30 @@ void computeTangentBasis(
 	std::vector<glm::vec3> & bitangents
 );
 
+// Indexed: one tangent per vertex, straight on an indexed mesh (the base
+// mesh or any subdivision level). Face tangents are computed in parallel,
+// then every vertex gathers its own faces through the vertex-corner table,
+// so no two threads write the same vertex. xyz is unit length and
+// orthogonal to the vertex normal; w is the handedness (+1 or -1), so the
+// bitangent is w * cross(normal, tangent). Faces with degenerate UVs are
+// skipped; a vertex left without a tangent gets an arbitrary one
+// perpendicular to its normal.
+void computeTangentBasis(
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	const std::vector<unsigned int> & indices,
+	std::vector<glm::vec4> & tangents
+);
+
+// Same, with the vertex-corner table of 'indices' already built.
+void computeTangentBasis(
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	const std::vector<unsigned int> & indices,
+	const VertexCorners & corners,
+	std::vector<glm::vec4> & tangents
+);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "threadpool.hpp"
+
+ThreadPool::ThreadPool(unsigned int threadCount) : stopping(false) {
+    if (threadCount == 0) {
+        unsigned int hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+    workers.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    condition.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+namespace {
+
+// Shared between the caller of parallelFor and the helper tasks it queues.
+// Helpers may be dequeued after the loop is over; they then find no range
+// left to claim and never touch the (by then dead) body.
+struct ParallelForJob {
+    std::atomic<size_t> nextRange{0};
+    size_t rangeCount = 0;
+    size_t count = 0;
+    size_t rangeSize = 0;
+    const std::function<void(size_t, size_t)> *body = nullptr;
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t completed = 0;
+
+    void run() {
+        size_t done = 0;
+        for (size_t r = nextRange++; r < rangeCount; r = nextRange++) {
+            size_t begin = r * rangeSize;
+            size_t end = std::min(count, begin + rangeSize);
+            (*body)(begin, end);
+            done++;
+        }
+        if (done > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            completed += done;
+            if (completed == rangeCount)
+                finished.notify_all();
+        }
+    }
+};
+
+} // namespace
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    if (count == 0)
+        return;
+    if (grain == 0)
+        grain = 1;
+
+    size_t maxRanges = (count + grain - 1) / grain;
+    size_t rangeCount = std::min(maxRanges, static_cast<size_t>(size()) + 1);
+    if (rangeCount <= 1) {
+        body(0, count);
+        return;
+    }
+
+    auto job = std::make_shared<ParallelForJob>();
+    job->count = count;
+    job->rangeSize = (count + rangeCount - 1) / rangeCount;
+    job->rangeCount = (count + job->rangeSize - 1) / job->rangeSize;
+    job->body = &body;
+
+    for (size_t i = 1; i < job->rangeCount; i++)
+        submit([job] { job->run(); });
+    job->run();
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&job] { return job->completed == job->rangeCount; });
+}
@@ -0,0 +1,45 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small fixed-size worker pool shared by the loaders and mesh processing code.
+class ThreadPool {
+public:
+    // threadCount == 0 uses one worker per hardware thread (minus the caller).
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Process-wide pool, created on first use.
+    static ThreadPool& shared();
+
+    unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+    // Queues a task to run on some worker thread.
+    void submit(std::function<void()> task);
+
+    // Splits [0, count) into contiguous ranges of at least 'grain' items and
+    // calls body(begin, end) for each, blocking until all have finished.
+    // The calling thread takes part, so this is safe to call from a worker.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping;
+};
+
+#endif
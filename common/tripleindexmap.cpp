@@ -0,0 +1,93 @@
+#include "tripleindexmap.hpp"
+
+namespace {
+
+// Keep the table at most 70% full.
+inline size_t capacityFor(size_t keys) {
+    size_t needed = keys + keys * 3 / 7 + 1;
+    size_t capacity = 16;
+    while (capacity < needed)
+        capacity <<= 1;
+    return capacity;
+}
+
+} // namespace
+
+TripleIndexMap::TripleIndexMap(size_t expectedKeys) : mask(0), count(0) {
+    if (expectedKeys > 0)
+        rehash(capacityFor(expectedKeys));
+}
+
+void TripleIndexMap::reserve(size_t keys) {
+    size_t capacity = capacityFor(keys);
+    if (capacity > slots.size())
+        rehash(capacity);
+}
+
+uint64_t TripleIndexMap::hash(unsigned int a, unsigned int b, unsigned int c) {
+    // Pack the 96-bit key into two words and run a 64-bit finalizer (murmur3 fmix64)
+    uint64_t h = (static_cast<uint64_t>(a) << 32 | b) * 0x9E3779B97F4A7C15ull;
+    h ^= static_cast<uint64_t>(c) * 0xC2B2AE3D27D4EB4Full;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+unsigned int TripleIndexMap::find(unsigned int a, unsigned int b, unsigned int c) const {
+    if (slots.empty())
+        return npos;
+    for (size_t i = hash(a, b, c) & mask;; i = (i + 1) & mask) {
+        const Slot &slot = slots[i];
+        if (slot.value == npos)
+            return npos;
+        if (slot.a == a && slot.b == b && slot.c == c)
+            return slot.value;
+    }
+}
+
+unsigned int TripleIndexMap::findOrInsert(unsigned int a, unsigned int b, unsigned int c, unsigned int value, bool &inserted) {
+    if (slots.empty() || (count + 1) * 10 > slots.size() * 7)
+        rehash(slots.empty() ? capacityFor(1) : slots.size() * 2);
+
+    for (size_t i = hash(a, b, c) & mask;; i = (i + 1) & mask) {
+        Slot &slot = slots[i];
+        if (slot.value == npos) {
+            slot.a = a;
+            slot.b = b;
+            slot.c = c;
+            slot.value = value;
+            count++;
+            inserted = true;
+            return value;
+        }
+        if (slot.a == a && slot.b == b && slot.c == c) {
+            inserted = false;
+            return slot.value;
+        }
+    }
+}
+
+void TripleIndexMap::clear() {
+    for (Slot &slot : slots)
+        slot.value = npos;
+    count = 0;
+}
+
+void TripleIndexMap::rehash(size_t newCapacity) {
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.assign(newCapacity, Slot{ 0, 0, 0, npos });
+    mask = newCapacity - 1;
+
+    for (const Slot &slot : old) {
+        if (slot.value == npos)
+            continue;
+        size_t i = hash(slot.a, slot.b, slot.c) & mask;
+        while (slots[i].value != npos)
+            i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef TRIPLEINDEXMAP_HPP
+#define TRIPLEINDEXMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Flat open-addressing hash map from a triple of 32-bit indices (e.g. an OBJ
+// v/vt/vn corner) to a 32-bit index. Entries live in one array with linear
+// probing, so a lookup is a hash plus a short scan and there is no per-entry
+// allocation. Keys cannot be removed.
+class TripleIndexMap {
+public:
+    static constexpr unsigned int npos = 0xFFFFFFFFu;
+
+    explicit TripleIndexMap(size_t expectedKeys = 0);
+
+    // Makes room for at least 'keys' entries without rehashing.
+    void reserve(size_t keys);
+
+    // Returns the value stored for (a, b, c), or npos.
+    unsigned int find(unsigned int a, unsigned int b, unsigned int c) const;
+
+    // Returns the value stored for (a, b, c). If the key is new, stores
+    // 'value' for it (which must not be npos) and sets 'inserted'.
+    unsigned int findOrInsert(unsigned int a, unsigned int b, unsigned int c, unsigned int value, bool &inserted);
+
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+    void clear();
+
+private:
+    struct Slot {
+        unsigned int a, b, c;
+        unsigned int value; // npos marks an empty slot
+    };
+
+    static uint64_t hash(unsigned int a, unsigned int b, unsigned int c);
+    void rehash(size_t newCapacity);
+
+    std::vector<Slot> slots; // Size is zero or a power of two
+    size_t mask;
+    size_t count;
+};
+
+#endif
@@ -6,70 +6,125 @@
 #include "vboindexer.hpp"
 
 #include <string.h> // for memcmp
+#include <cmath>
+#include <algorithm>
+
+#include "tripleindexmap.hpp"
+
+static const unsigned int noVertex = 0xFFFFFFFFu;
 
 
 // Returns true iif v1 can be considered equal to v2
-bool is_near(float v1, float v2){
-	return fabs( v1-v2 ) < 0.01f;
+bool is_near(float v1, float v2, float tolerance){
+	return fabs( v1-v2 ) < tolerance;
 }
 
-// Searches through all already-exported vertices
-// for a similar one.
-// Similar = same position + same UVs + same normal
-bool getSimilarVertexIndex( 
-	glm::vec3 & in_vertex, 
-	glm::vec2 & in_uv, 
-	glm::vec3 & in_normal, 
-	std::vector<glm::vec3> & out_vertices,
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals,
-	unsigned short & result
+// Similar = same position + same UVs + same normal, within the tolerance
+bool is_similar(
+	const glm::vec3 & v1, const glm::vec2 & uv1, const glm::vec3 & n1,
+	const glm::vec3 & v2, const glm::vec2 & uv2, const glm::vec3 & n2,
+	float tolerance
 ){
-	// Lame linear search
-	for ( unsigned int i=0; i<out_vertices.size(); i++ ){
-		if (
-			is_near( in_vertex.x , out_vertices[i].x ) &&
-			is_near( in_vertex.y , out_vertices[i].y ) &&
-			is_near( in_vertex.z , out_vertices[i].z ) &&
-			is_near( in_uv.x     , out_uvs     [i].x ) &&
-			is_near( in_uv.y     , out_uvs     [i].y ) &&
-			is_near( in_normal.x , out_normals [i].x ) &&
-			is_near( in_normal.y , out_normals [i].y ) &&
-			is_near( in_normal.z , out_normals [i].z )
-		){
-			result = i;
-			return true;
+	return
+		is_near( v1.x , v2.x , tolerance ) &&
+		is_near( v1.y , v2.y , tolerance ) &&
+		is_near( v1.z , v2.z , tolerance ) &&
+		is_near( uv1.x, uv2.x, tolerance ) &&
+		is_near( uv1.y, uv2.y, tolerance ) &&
+		is_near( n1.x , n2.x , tolerance ) &&
+		is_near( n1.y , n2.y , tolerance ) &&
+		is_near( n1.z , n2.z , tolerance );
+}
+
+// Uniform spatial hash over the already-exported vertices, replacing the
+// linear search through all of them. Cells are twice the tolerance wide, so
+// every position within the tolerance of a vertex lies in its own cell or in
+// the neighbour on the nearer side along each axis: at most 8 cells to probe.
+// Each cell keeps a chain of the vertices in it.
+struct VertexWelder {
+	const float tolerance;
+	const float cellSize;
+	TripleIndexMap cells;                 // Cell coordinates -> cell number
+	std::vector<unsigned int> cellHeads;  // Cell number -> most recently added vertex
+	std::vector<unsigned int> next;       // Vertex -> previous vertex in its cell
+
+	VertexWelder(float tolerance, size_t expectedVertices)
+		: tolerance(tolerance), cellSize(2.0f * tolerance), cells(expectedVertices) {
+		next.reserve(expectedVertices);
+	}
+
+	int cell(float x) const {
+		return (int)std::floor( std::max(-2.0e9f, std::min(2.0e9f, x / cellSize)) );
+	}
+
+	// Returns the lowest-numbered similar vertex, like the linear search did, or noVertex
+	unsigned int find(
+		const glm::vec3 & in_vertex, const glm::vec2 & in_uv, const glm::vec3 & in_normal,
+		const std::vector<glm::vec3> & out_vertices,
+		const std::vector<glm::vec2> & out_uvs,
+		const std::vector<glm::vec3> & out_normals
+	) const {
+		int base[3], side[3];
+		for ( int k=0; k<3; k++ ){
+			float scaled = in_vertex[k] / cellSize;
+			base[k] = cell(in_vertex[k]);
+			side[k] = (scaled - std::floor(scaled) < 0.5f) ? -1 : 1;
 		}
+
+		unsigned int best = noVertex;
+		for ( int probe=0; probe<8; probe++ ){
+			unsigned int c = cells.find(
+				(unsigned int)(base[0] + ((probe & 1) ? side[0] : 0)),
+				(unsigned int)(base[1] + ((probe & 2) ? side[1] : 0)),
+				(unsigned int)(base[2] + ((probe & 4) ? side[2] : 0)) );
+			if ( c == TripleIndexMap::npos )
+				continue;
+			for ( unsigned int i=cellHeads[c]; i!=noVertex; i=next[i] ){
+				if ( i < best && is_similar(in_vertex, in_uv, in_normal, out_vertices[i], out_uvs[i], out_normals[i], tolerance) )
+					best = i;
+			}
+		}
+		return best;
 	}
-	// No other vertex could be used instead.
-	// Looks like we'll have to add it to the VBO.
-	return false;
-}
 
-void indexVBO_slow(
+	void add(const glm::vec3 & position, unsigned int index){
+		bool inserted = false;
+		unsigned int c = cells.findOrInsert( (unsigned int)cell(position.x), (unsigned int)cell(position.y), (unsigned int)cell(position.z),
+		                                     (unsigned int)cellHeads.size(), inserted );
+		if ( inserted )
+			cellHeads.push_back( noVertex );
+		next.push_back( cellHeads[c] );
+		cellHeads[c] = index;
+	}
+};
+
+void indexVBO_weld(
 	std::vector<glm::vec3> & in_vertices,
 	std::vector<glm::vec2> & in_uvs,
 	std::vector<glm::vec3> & in_normals,
 
-	std::vector<unsigned short> & out_indices,
+	std::vector<unsigned int> & out_indices,
 	std::vector<glm::vec3> & out_vertices,
 	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals
+	std::vector<glm::vec3> & out_normals,
+	float tolerance
 ){
+	VertexWelder welder(tolerance, in_vertices.size());
+
 	// For each input vertex
 	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
 
 		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals, index);
+		unsigned int index = welder.find(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals);
 
-		if ( found ){ // A similar vertex is already in the VBO, use it instead !
+		if ( index != noVertex ){ // A similar vertex is already in the VBO, use it instead !
 			out_indices.push_back( index );
 		}else{ // If not, it needs to be added in the output data.
 			out_vertices.push_back( in_vertices[i]);
 			out_uvs     .push_back( in_uvs[i]);
 			out_normals .push_back( in_normals[i]);
-			out_indices .push_back( (unsigned short)out_vertices.size() - 1 );
+			out_indices .push_back( (unsigned int)out_vertices.size() - 1 );
+			welder.add( in_vertices[i], out_indices.back() );
 		}
 	}
 }
@@ -85,10 +140,10 @@ struct PackedVertex{
 
 bool getSimilarVertexIndex_fast( 
 	PackedVertex & packed, 
-	std::map<PackedVertex,unsigned short> & VertexToOutIndex,
-	unsigned short & result
+	std::map<PackedVertex,unsigned int> & VertexToOutIndex,
+	unsigned int & result
 ){
-	std::map<PackedVertex,unsigned short>::iterator it = VertexToOutIndex.find(packed);
+	std::map<PackedVertex,unsigned int>::iterator it = VertexToOutIndex.find(packed);
 	if ( it == VertexToOutIndex.end() ){
 		return false;
 	}else{
@@ -102,12 +157,12 @@ void indexVBO(
 	std::vector<glm::vec2> & in_uvs,
 	std::vector<glm::vec3> & in_normals,
 
-	std::vector<unsigned short> & out_indices,
+	std::vector<unsigned int> & out_indices,
 	std::vector<glm::vec3> & out_vertices,
 	std::vector<glm::vec2> & out_uvs,
 	std::vector<glm::vec3> & out_normals
 ){
-	std::map<PackedVertex,unsigned short> VertexToOutIndex;
+	std::map<PackedVertex,unsigned int> VertexToOutIndex;
 
 	// For each input vertex
 	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
@@ -116,7 +171,7 @@ void indexVBO(
 		
 
 		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
+		unsigned int index;
 		bool found = getSimilarVertexIndex_fast( packed, VertexToOutIndex, index);
 
 		if ( found ){ // A similar vertex is already in the VBO, use it instead !
@@ -125,7 +180,7 @@ void indexVBO(
 			out_vertices.push_back( in_vertices[i]);
 			out_uvs     .push_back( in_uvs[i]);
 			out_normals .push_back( in_normals[i]);
-			unsigned short newindex = (unsigned short)out_vertices.size() - 1;
+			unsigned int newindex = (unsigned int)out_vertices.size() - 1;
 			out_indices .push_back( newindex );
 			VertexToOutIndex[ packed ] = newindex;
 		}
@@ -145,21 +200,23 @@ void indexVBO_TBN(
 	std::vector<glm::vec3> & in_tangents,
 	std::vector<glm::vec3> & in_bitangents,
 
-	std::vector<unsigned short> & out_indices,
+	std::vector<unsigned int> & out_indices,
 	std::vector<glm::vec3> & out_vertices,
 	std::vector<glm::vec2> & out_uvs,
 	std::vector<glm::vec3> & out_normals,
 	std::vector<glm::vec3> & out_tangents,
-	std::vector<glm::vec3> & out_bitangents
+	std::vector<glm::vec3> & out_bitangents,
+	float tolerance
 ){
+	VertexWelder welder(tolerance, in_vertices.size());
+
 	// For each input vertex
 	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
 
 		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals, index);
+		unsigned int index = welder.find(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals);
 
-		if ( found ){ // A similar vertex is already in the VBO, use it instead !
+		if ( index != noVertex ){ // A similar vertex is already in the VBO, use it instead !
 			out_indices.push_back( index );
 
 			// Average the tangents and the bitangents
@@ -171,7 +228,8 @@ void indexVBO_TBN(
 			out_normals .push_back( in_normals[i]);
 			out_tangents .push_back( in_tangents[i]);
 			out_bitangents .push_back( in_bitangents[i]);
-			out_indices .push_back( (unsigned short)out_vertices.size() - 1 );
+			out_indices .push_back( (unsigned int)out_vertices.size() - 1 );
+			welder.add( in_vertices[i], out_indices.back() );
 		}
 	}
 }
@@ -0,0 +1,123 @@
+#include <vector>
+
+#include "vertexcache.hpp"
+#include "meshtopology.hpp"
+
+namespace {
+
+const unsigned int noVertex = 0xFFFFFFFFu;
+
+// Tipsify's next fanning vertex: the candidate with live triangles that will
+// be oldest in the cache yet still in it after its fan is emitted
+unsigned int nextFanningVertex(const std::vector<unsigned int> &candidates, const std::vector<unsigned int> &liveTriangles,
+                               const std::vector<unsigned int> &cacheTime, unsigned int time, unsigned int cacheSize) {
+    unsigned int best = noVertex;
+    int bestPriority = -1;
+    for (unsigned int v : candidates) {
+        if (liveTriangles[v] == 0)
+            continue;
+        // Each live triangle may push up to two new vertices into the cache
+        int priority = 0;
+        if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+            priority = static_cast<int>(time - cacheTime[v]);
+        if (priority > bestPriority) {
+            bestPriority = priority;
+            best = v;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize) {
+    VertexCacheStats stats = { 0.0f, 0.0f };
+    if (indices.size() < 3)
+        return stats;
+
+    // A vertex is in the FIFO while fewer than cacheSize misses happened since its own
+    std::vector<size_t> missTime(vertexCount, 0);
+    std::vector<unsigned char> used(vertexCount, 0);
+    size_t misses = 0, referenced = 0;
+    for (unsigned int v : indices) {
+        if (!used[v]) {
+            used[v] = 1;
+            referenced++;
+        }
+        if (missTime[v] == 0 || misses + 1 - missTime[v] > cacheSize) {
+            misses++;
+            missTime[v] = misses;
+        }
+    }
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(referenced);
+    return stats;
+}
+
+void optimizeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, std::vector<unsigned int> &out_indices,
+                         unsigned int cacheSize) {
+    const size_t triangleCount = indices.size() / 3;
+    out_indices.clear();
+    out_indices.reserve(triangleCount * 3);
+
+    VertexCorners corners;
+    buildVertexCornerTable(indices, vertexCount, corners);
+    std::vector<unsigned int> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        liveTriangles[v] = corners.offsets[v + 1] - corners.offsets[v];
+
+    // Cache time stamps start far enough in the past to count as evicted
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    std::vector<unsigned char> emitted(triangleCount, 0);
+    std::vector<unsigned int> deadEnds; // Recently used vertices to fall back on
+    std::vector<unsigned int> candidates;
+    size_t cursor = 0; // Input order fallback once the dead-end stack runs dry
+
+    unsigned int fan = vertexCount > 0 ? 0 : noVertex;
+    while (fan != noVertex) {
+        candidates.clear();
+        for (unsigned int j = corners.offsets[fan]; j < corners.offsets[fan + 1]; j++) {
+            const unsigned int t = corners.corners[j] / 3;
+            if (emitted[t])
+                continue;
+            emitted[t] = 1;
+            for (int k = 0; k < 3; k++) {
+                const unsigned int v = indices[3 * t + k];
+                out_indices.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (time - cacheTime[v] > cacheSize)
+                    cacheTime[v] = time++;
+            }
+        }
+
+        fan = nextFanningVertex(candidates, liveTriangles, cacheTime, time, cacheSize);
+        while (fan == noVertex && !deadEnds.empty()) {
+            const unsigned int v = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[v] > 0)
+                fan = v;
+        }
+        while (fan == noVertex && cursor < vertexCount) {
+            if (liveTriangles[cursor] > 0)
+                fan = static_cast<unsigned int>(cursor);
+            cursor++;
+        }
+    }
+}
+
+void optimizeVertexFetch(std::vector<unsigned int> &indices, size_t vertexCount, std::vector<unsigned int> &remap) {
+    remap.assign(vertexCount, noVertex);
+    unsigned int next = 0;
+    for (unsigned int &v : indices) {
+        if (remap[v] == noVertex)
+            remap[v] = next++;
+        v = remap[v];
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (remap[v] == noVertex)
+            remap[v] = next++;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef VERTEXCACHE_HPP
+#define VERTEXCACHE_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Triangle and vertex ordering for the GPU's post-transform vertex cache and
+// its vertex fetch. Neither changes the mesh, only the order it is stored in.
+
+// Size of the FIFO cache the optimizer targets and the statistics simulate
+const unsigned int defaultVertexCacheSize = 16;
+
+// How well an index buffer reuses transformed vertices through a FIFO cache.
+struct VertexCacheStats {
+    float acmr; // Average cache miss ratio: vertex shader runs per triangle (0.5 is ideal for large meshes, 3 the worst)
+    float atvr; // Average transformed vertex ratio: vertex shader runs per referenced vertex (1 is ideal)
+};
+
+// Simulates drawing 'indices' through a FIFO cache of 'cacheSize' entries.
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                    unsigned int cacheSize = defaultVertexCacheSize);
+
+// Reorders triangles for the post-transform cache with Tipsify (Sander,
+// Nehab and Barczak 2007): fans around one vertex at a time and moves on to
+// the neighbour that will still be in the cache, in time linear in the mesh
+// size. The triangles keep their winding.
+void optimizeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, std::vector<unsigned int> &out_indices,
+                         unsigned int cacheSize = defaultVertexCacheSize);
+
+// Renumbers the vertices in the order the triangles first use them, so vertex
+// fetch walks the vertex arrays front to back. Rewrites 'indices' and fills
+// remap[old] = new; vertices no triangle uses go last, in their old order.
+void optimizeVertexFetch(std::vector<unsigned int> &indices, size_t vertexCount, std::vector<unsigned int> &remap);
+
+// Moves per-vertex data to the order optimizeVertexFetch chose.
+template <typename T>
+void remapVertices(std::vector<T> &data, const std::vector<unsigned int> &remap) {
+    if (data.size() != remap.size())
+        return;
+    std::vector<T> reordered(data.size());
+    for (size_t v = 0; v < data.size(); v++)
+        reordered[remap[v]] = data[v];
+    data.swap(reordered);
+}
+
+#endif
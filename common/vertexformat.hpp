@@ -0,0 +1,32 @@
+#ifndef VERTEXFORMAT_HPP
+#define VERTEXFORMAT_HPP
+
+#include <cstddef>
+
+#include "vertexlayout.hpp"
+
+// How mesh vertices are stored on the GPU. Both feed the same shader inputs
+// (position at location 0, UV at 1, normal at 2); the packed attributes are
+// decoded by vertex fetch, apart from the position's scale and offset, which
+// go into the transform (PositionQuantization::decode).
+//
+// Separate: three float streams, 12 + 8 + 12 = 32 bytes per vertex.
+// Packed:   one interleaved stream, 16 bytes per vertex.
+enum class VertexFormat { Separate, Packed };
+
+typedef VertexLayout<FloatAttribute<0, glm::vec3>> PositionStream;
+typedef VertexLayout<FloatAttribute<1, glm::vec2>> UvStream;
+typedef VertexLayout<FloatAttribute<2, glm::vec3>> NormalStream;
+
+// Position as 16-bit fractions of the mesh's box, normal as signed
+// 10_10_10_2 and UV as two half floats
+typedef VertexLayout<Unorm16Position<0>, Snorm10Normal<2>, HalfFloat2<1>> PackedLayout;
+static_assert(PackedLayout::stride == 16, "packed vertices should stay 16 bytes");
+
+// Bytes one vertex takes on the GPU
+constexpr size_t vertexBytes(VertexFormat format) {
+    return (format == VertexFormat::Packed) ? PackedLayout::stride
+                                            : PositionStream::stride + UvStream::stride + NormalStream::stride;
+}
+
+#endif
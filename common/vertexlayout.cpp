@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VERTEXLAYOUT_SSE2
+#endif
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "vertexlayout.hpp"
+
+namespace {
+
+// Rounds to nearest even, like the SSE2 conversions
+inline int roundToInt(float value) {
+    return static_cast<int>(std::nearbyint(value));
+}
+
+inline void storeUnorm16(unsigned char *out, int x, int y, int z) {
+    uint16_t value[4] = { uint16_t(x), uint16_t(y), uint16_t(z), 0 };
+    std::memcpy(out, value, sizeof(value));
+}
+
+inline void storeSnorm10(unsigned char *out, int x, int y, int z) {
+    uint32_t packed = (uint32_t(x) & 0x3FF) | ((uint32_t(y) & 0x3FF) << 10) | ((uint32_t(z) & 0x3FF) << 20);
+    std::memcpy(out, &packed, sizeof(packed));
+}
+
+inline void storeHalf2(unsigned char *out, const glm::vec2 &v) {
+    uint32_t packed = glm::packHalf2x16(v);
+    std::memcpy(out, &packed, sizeof(packed));
+}
+
+#ifdef VERTEXLAYOUT_SSE2
+// Four vec3s are three registers: xyzx yzxy zxyz. A per-axis constant
+// rotated the same way lines up with them.
+struct AxisLanes {
+    __m128 lane[3];
+    explicit AxisLanes(const glm::vec3 &v) {
+        lane[0] = _mm_setr_ps(v.x, v.y, v.z, v.x);
+        lane[1] = _mm_setr_ps(v.y, v.z, v.x, v.y);
+        lane[2] = _mm_setr_ps(v.z, v.x, v.y, v.z);
+    }
+};
+
+// Scales four vec3s per axis, clamps them to [lo, hi] and rounds them: twelve ints, vertex by vertex
+inline void scaleAndRound(const glm::vec3 *in, const AxisLanes &offset, const AxisLanes &scale, __m128 lo, __m128 hi, int32_t out[12]) {
+    const float *p = &in[0].x;
+    for (int r = 0; r < 3; r++) {
+        __m128 v = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(p + 4 * r), offset.lane[r]), scale.lane[r]);
+        v = _mm_min_ps(_mm_max_ps(v, lo), hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4 * r), _mm_cvtps_epi32(v));
+    }
+}
+
+// Four floats to halves (round to nearest even), each in the low 16 bits of
+// a lane; after Fabian Giesen's float_to_half_fast3_rtne
+inline __m128i floatToHalf(__m128 f) {
+    const __m128i f16max = _mm_set1_epi32((127 + 16) << 23);     // Rounds to infinity from here
+    const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);  // Smallest that is normal as a half
+    const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i normalBias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+
+    __m128 sign = _mm_and_ps(f, _mm_castsi128_ps(_mm_set1_epi32(int(0x80000000u))));
+    __m128 absf = _mm_xor_ps(f, sign);
+    __m128i absBits = _mm_castps_si128(absf);
+    __m128i isNan = _mm_castps_si128(_mm_cmpunord_ps(absf, absf));
+    __m128i isRegular = _mm_cmpgt_epi32(f16max, absBits);
+    __m128i special = _mm_or_si128(_mm_and_si128(isNan, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+    __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absBits);
+    __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absf, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+    __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absBits, 31 - 13), 31);
+    __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absBits, normalBias), mantissaOdd), 13);
+
+    __m128i finite = _mm_or_si128(_mm_and_si128(subnormal, isSubnormal), _mm_andnot_si128(isSubnormal, normal));
+    __m128i joined = _mm_or_si128(_mm_and_si128(finite, isRegular), _mm_andnot_si128(isRegular, special));
+    return _mm_or_si128(joined, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+}
+#endif
+
+} // namespace
+
+PositionQuantization PositionQuantization::fit(const glm::vec3 *positions, size_t count) {
+    PositionQuantization q;
+    if (count == 0)
+        return q;
+    glm::vec3 lo = positions[0], hi = positions[0];
+    for (size_t i = 1; i < count; i++) {
+        lo = glm::min(lo, positions[i]);
+        hi = glm::max(hi, positions[i]);
+    }
+    q.origin = lo;
+    q.extent = glm::max(hi - lo, glm::vec3(1e-6f));
+    return q;
+}
+
+glm::mat4 PositionQuantization::decode() const {
+    return glm::scale(glm::translate(glm::mat4(1.0f), origin), extent);
+}
+
+void encodeUnorm16Positions(const glm::vec3 *in, size_t count, const PositionQuantization &quantization, unsigned char *out, size_t stride) {
+    glm::vec3 scale = glm::vec3(65535.0f) / quantization.extent;
+    size_t i = 0;
+#ifdef VERTEXLAYOUT_SSE2
+    AxisLanes offsetLanes(quantization.origin), scaleLanes(scale);
+    __m128 lo = _mm_setzero_ps(), hi = _mm_set1_ps(65535.0f);
+    int32_t q[12];
+    for (; i + 4 <= count; i += 4) {
+        scaleAndRound(in + i, offsetLanes, scaleLanes, lo, hi, q);
+        for (int v = 0; v < 4; v++)
+            storeUnorm16(out + (i + v) * stride, q[3 * v], q[3 * v + 1], q[3 * v + 2]);
+    }
+#endif
+    for (; i < count; i++) {
+        glm::vec3 u = glm::clamp((in[i] - quantization.origin) * scale, 0.0f, 65535.0f);
+        storeUnorm16(out + i * stride, roundToInt(u.x), roundToInt(u.y), roundToInt(u.z));
+    }
+}
+
+void encodeSnorm10Normals(const glm::vec3 *in, size_t count, unsigned char *out, size_t stride) {
+    size_t i = 0;
+#ifdef VERTEXLAYOUT_SSE2
+    AxisLanes offsetLanes(glm::vec3(0.0f)), scaleLanes(glm::vec3(511.0f));
+    __m128 lo = _mm_set1_ps(-511.0f), hi = _mm_set1_ps(511.0f);
+    int32_t q[12];
+    for (; i + 4 <= count; i += 4) {
+        scaleAndRound(in + i, offsetLanes, scaleLanes, lo, hi, q);
+        for (int v = 0; v < 4; v++)
+            storeSnorm10(out + (i + v) * stride, q[3 * v], q[3 * v + 1], q[3 * v + 2]);
+    }
+#endif
+    for (; i < count; i++) {
+        glm::vec3 s = glm::clamp(in[i], -1.0f, 1.0f) * 511.0f;
+        storeSnorm10(out + i * stride, roundToInt(s.x), roundToInt(s.y), roundToInt(s.z));
+    }
+}
+
+void encodeHalfFloats(const glm::vec2 *in, size_t count, unsigned char *out, size_t stride) {
+    size_t i = 0;
+#ifdef VERTEXLAYOUT_SSE2
+    const __m128i low16 = _mm_set1_epi32(0xFFFF);
+    for (; i + 2 <= count; i += 2) {
+        __m128i halves = _mm_and_si128(floatToHalf(_mm_loadu_ps(&in[i].x)), low16);
+        // Each 64-bit half becomes u | v << 16 in its low 32 bits
+        __m128i pairs = _mm_or_si128(halves, _mm_srli_epi64(halves, 16));
+        uint32_t first = uint32_t(_mm_cvtsi128_si32(pairs));
+        uint32_t second = uint32_t(_mm_cvtsi128_si32(_mm_srli_si128(pairs, 8)));
+        std::memcpy(out + i * stride, &first, sizeof(first));
+        std::memcpy(out + (i + 1) * stride, &second, sizeof(second));
+    }
+#endif
+    for (; i < count; i++)
+        storeHalf2(out + i * stride, in[i]);
+}
+
+void decodeUnorm16Positions(const unsigned char *in, size_t stride, size_t count, const PositionQuantization &quantization, glm::vec3 *out) {
+    glm::vec3 step = quantization.extent / 65535.0f;
+    for (size_t i = 0; i < count; i++) {
+        uint16_t value[4];
+        std::memcpy(value, in + i * stride, sizeof(value));
+        out[i] = quantization.origin + glm::vec3(value[0], value[1], value[2]) * step;
+    }
+}
+
+void decodeSnorm10Normals(const unsigned char *in, size_t stride, size_t count, glm::vec3 *out) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t packed;
+        std::memcpy(&packed, in + i * stride, sizeof(packed));
+        out[i] = glm::vec3(glm::unpackSnorm3x10_1x2(packed));
+    }
+}
+
+void decodeHalfFloats(const unsigned char *in, size_t stride, size_t count, glm::vec2 *out) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t packed;
+        std::memcpy(&packed, in + i * stride, sizeof(packed));
+        out[i] = glm::unpackHalf2x16(packed);
+    }
+}
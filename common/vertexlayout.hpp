@@ -0,0 +1,214 @@
+#ifndef VERTEXLAYOUT_HPP
+#define VERTEXLAYOUT_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Vertex layouts described at compile time. A layout is a list of attribute
+// types, each knowing its shader location, how GL reads it and how it is
+// encoded from (and decoded to) a mesh array. VertexLayout<...> turns the
+// list into the stride and offsets, the glVertexAttribPointer calls and the
+// pack/unpack loops between the mesh's separate arrays and the interleaved
+// vertices, with nothing looked up at run time.
+//
+// An attribute type provides:
+//   Source      element of the mesh array it is packed from
+//   Stored      what a vertex holds (its size is the attribute's size)
+//   location    first shader location; 'columns' consecutive ones are used
+//   type, components, normalized   as passed to glVertexAttribPointer
+//   encode(in, count, quantization, out, stride)
+//   decode(in, stride, count, quantization, out)
+// where 'out'/'in' point at the attribute in the first vertex.
+
+// The box quantized positions are fractions of. Points outside it are clamped.
+struct PositionQuantization {
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 extent = glm::vec3(1.0f);
+
+    // The bounding box of 'count' points (never flat in any axis)
+    static PositionQuantization fit(const glm::vec3 *positions, size_t count);
+
+    // Maps the unit cube the GPU decodes positions into onto the box
+    glm::mat4 decode() const;
+};
+
+// Batch encoders behind the attribute types below, vectorized where SSE2 is
+// available. Each writes one value per 'stride' bytes of 'out'.
+void encodeUnorm16Positions(const glm::vec3 *in, size_t count, const PositionQuantization &quantization, unsigned char *out, size_t stride);
+void encodeSnorm10Normals(const glm::vec3 *in, size_t count, unsigned char *out, size_t stride);
+void encodeHalfFloats(const glm::vec2 *in, size_t count, unsigned char *out, size_t stride);
+void decodeUnorm16Positions(const unsigned char *in, size_t stride, size_t count, const PositionQuantization &quantization, glm::vec3 *out);
+void decodeSnorm10Normals(const unsigned char *in, size_t stride, size_t count, glm::vec3 *out);
+void decodeHalfFloats(const unsigned char *in, size_t stride, size_t count, glm::vec2 *out);
+
+// Floats stored as they are: a vector or scalar, or a matrix over 'Columns'
+// locations (one column each)
+template <GLuint Location, typename T, int Columns = 1>
+struct FloatAttribute {
+    typedef T Source;
+    typedef T Stored;
+    static constexpr GLuint location = Location;
+    static constexpr int columns = Columns;
+    static constexpr GLenum type = GL_FLOAT;
+    static constexpr GLint components = GLint(sizeof(T) / sizeof(float) / Columns);
+    static constexpr GLboolean normalized = GL_FALSE;
+
+    static void encode(const Source *in, size_t count, const PositionQuantization &, unsigned char *out, size_t stride) {
+        for (size_t i = 0; i < count; i++)
+            std::memcpy(out + i * stride, &in[i], sizeof(Stored));
+    }
+    static void decode(const unsigned char *in, size_t stride, size_t count, const PositionQuantization &, Source *out) {
+        for (size_t i = 0; i < count; i++)
+            std::memcpy(&out[i], in + i * stride, sizeof(Stored));
+    }
+};
+
+// A position as three 16-bit fractions of the quantization box, padded to 8
+// bytes. The shader gets the unit-cube position; PositionQuantization::decode
+// belongs in its transform.
+template <GLuint Location>
+struct Unorm16Position {
+    typedef glm::vec3 Source;
+    struct Stored {
+        uint16_t value[4];
+    };
+    static constexpr GLuint location = Location;
+    static constexpr int columns = 1;
+    static constexpr GLenum type = GL_UNSIGNED_SHORT;
+    static constexpr GLint components = 3;
+    static constexpr GLboolean normalized = GL_TRUE;
+
+    static void encode(const Source *in, size_t count, const PositionQuantization &q, unsigned char *out, size_t stride) {
+        encodeUnorm16Positions(in, count, q, out, stride);
+    }
+    static void decode(const unsigned char *in, size_t stride, size_t count, const PositionQuantization &q, Source *out) {
+        decodeUnorm16Positions(in, stride, count, q, out);
+    }
+};
+
+// A unit vector as signed 10_10_10_2 (w is 0)
+template <GLuint Location>
+struct Snorm10Normal {
+    typedef glm::vec3 Source;
+    typedef uint32_t Stored;
+    static constexpr GLuint location = Location;
+    static constexpr int columns = 1;
+    static constexpr GLenum type = GL_INT_2_10_10_10_REV;
+    static constexpr GLint components = 4;
+    static constexpr GLboolean normalized = GL_TRUE;
+
+    static void encode(const Source *in, size_t count, const PositionQuantization &, unsigned char *out, size_t stride) {
+        encodeSnorm10Normals(in, count, out, stride);
+    }
+    static void decode(const unsigned char *in, size_t stride, size_t count, const PositionQuantization &, Source *out) {
+        decodeSnorm10Normals(in, stride, count, out);
+    }
+};
+
+// Two half floats (e.g. a UV)
+template <GLuint Location>
+struct HalfFloat2 {
+    typedef glm::vec2 Source;
+    typedef uint32_t Stored;
+    static constexpr GLuint location = Location;
+    static constexpr int columns = 1;
+    static constexpr GLenum type = GL_HALF_FLOAT;
+    static constexpr GLint components = 2;
+    static constexpr GLboolean normalized = GL_FALSE;
+
+    static void encode(const Source *in, size_t count, const PositionQuantization &, unsigned char *out, size_t stride) {
+        encodeHalfFloats(in, count, out, stride);
+    }
+    static void decode(const unsigned char *in, size_t stride, size_t count, const PositionQuantization &, Source *out) {
+        decodeHalfFloats(in, stride, count, out);
+    }
+};
+
+// Interleaved vertices of the given attributes, in order and unpadded. A
+// layout of one attribute describes one stream of a non-interleaved mesh.
+template <typename... Attributes>
+struct VertexLayout {
+    static constexpr size_t attributeCount = sizeof...(Attributes);
+    static constexpr size_t stride = (sizeof(typename Attributes::Stored) + ...);
+
+    // Byte offset of each attribute in a vertex
+    static constexpr std::array<size_t, attributeCount> offsets() {
+        std::array<size_t, attributeCount> result{};
+        size_t at = 0, i = 0;
+        ((result[i++] = at, at += sizeof(typename Attributes::Stored)), ...);
+        return result;
+    }
+
+    // Points the attributes of the bound VAO at vertices in 'buffer' starting
+    // 'base' bytes in, advancing per instance if 'divisor' is not 0. Leaves
+    // 'buffer' bound to GL_ARRAY_BUFFER.
+    static void bind(GLuint buffer, size_t base = 0, GLuint divisor = 0) {
+        constexpr std::array<size_t, attributeCount> at = offsets();
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        size_t i = 0;
+        (bindAttribute<Attributes>(base + at[i++], divisor), ...);
+    }
+
+    // Disables the attributes' locations on the bound VAO
+    static void disable() {
+        (disableAttribute<Attributes>(), ...);
+    }
+
+    // Packs 'count' vertices into 'out' (count * stride bytes) from one array
+    // per attribute, in the order of the list. A null array packs zeros.
+    static void pack(unsigned char *out, size_t count, const PositionQuantization &quantization,
+                     const typename Attributes::Source *...sources) {
+        constexpr std::array<size_t, attributeCount> at = offsets();
+        size_t i = 0;
+        (packAttribute<Attributes>(sources, count, quantization, out + at[i++]), ...);
+    }
+
+    // The reverse: fills one array per attribute (null ones are skipped)
+    static void unpack(const unsigned char *in, size_t count, const PositionQuantization &quantization,
+                       typename Attributes::Source *...targets) {
+        constexpr std::array<size_t, attributeCount> at = offsets();
+        size_t i = 0;
+        (unpackAttribute<Attributes>(in + at[i++], count, quantization, targets), ...);
+    }
+
+private:
+    template <typename A>
+    static void bindAttribute(size_t offset, GLuint divisor) {
+        for (int c = 0; c < A::columns; c++) {
+            GLuint location = A::location + c;
+            size_t columnOffset = offset + c * (sizeof(typename A::Stored) / A::columns);
+            glVertexAttribPointer(location, A::components, A::type, A::normalized, GLsizei(stride), (void *)columnOffset);
+            glVertexAttribDivisor(location, divisor);
+            glEnableVertexAttribArray(location);
+        }
+    }
+
+    template <typename A>
+    static void disableAttribute() {
+        for (int c = 0; c < A::columns; c++)
+            glDisableVertexAttribArray(A::location + c);
+    }
+
+    template <typename A>
+    static void packAttribute(const typename A::Source *source, size_t count, const PositionQuantization &quantization, unsigned char *out) {
+        if (source) {
+            A::encode(source, count, quantization, out, stride);
+            return;
+        }
+        for (size_t v = 0; v < count; v++)
+            std::memset(out + v * stride, 0, sizeof(typename A::Stored));
+    }
+
+    template <typename A>
+    static void unpackAttribute(const unsigned char *in, size_t count, const PositionQuantization &quantization, typename A::Source *target) {
+        if (target)
+            A::decode(in, stride, count, quantization, target);
+    }
+};
+
+#endif
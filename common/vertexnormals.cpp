@@ -0,0 +1,308 @@
+#include <cmath>
+#include <cstddef>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VERTEXNORMALS_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VERTEXNORMALS_SSE2
+#endif
+
+#include "vertexnormals.hpp"
+#include "meshtopology.hpp"
+#include "threadpool.hpp"
+
+namespace {
+
+const size_t grain = 8192;
+
+// Face normal padded to 16 bytes, so the per-vertex gather is one aligned load
+struct alignas(16) FaceNormal {
+    float x, y, z, w;
+    FaceNormal() {} // Left uninitialised; pass 1 writes every element
+};
+
+// One face at a time; used for the tail of each range, when there is no SIMD
+// and by the scatter. 'angles' receives the corner angles in Angle mode.
+void faceNormalScalar(const float *p, const unsigned int *idx, size_t f, NormalWeighting weighting, FaceNormal &out, float *angles) {
+    const float *a = p + 3 * size_t(idx[3 * f]);
+    const float *b = p + 3 * size_t(idx[3 * f + 1]);
+    const float *c = p + 3 * size_t(idx[3 * f + 2]);
+    float e1x = b[0] - a[0], e1y = b[1] - a[1], e1z = b[2] - a[2];
+    float e2x = c[0] - a[0], e2y = c[1] - a[1], e2z = c[2] - a[2];
+    float nx = e1y * e2z - e2y * e1z;
+    float ny = e1z * e2x - e2z * e1x;
+    float nz = e1x * e2y - e2x * e1y;
+    float len = std::sqrt(nx * nx + ny * ny + nz * nz);
+
+    float scale = 1.0f;
+    if (weighting != NormalWeighting::Area)
+        scale = (len > 0.0f) ? 1.0f / len : 0.0f;
+    out.x = nx * scale;
+    out.y = ny * scale;
+    out.z = nz * scale;
+    out.w = 0.0f;
+
+    if (weighting == NormalWeighting::Angle) {
+        // atan2(|e1 x e2|, e1 . e2) at each corner; |cross| is the same for all three
+        float ex = c[0] - b[0], ey = c[1] - b[1], ez = c[2] - b[2];
+        float d0 = e1x * e2x + e1y * e2y + e1z * e2z;
+        float d1 = -(e1x * ex + e1y * ey + e1z * ez);
+        float d2 = e2x * ex + e2y * ey + e2z * ez;
+        angles[0] = std::atan2(len, d0);
+        angles[1] = std::atan2(len, d1);
+        angles[2] = std::atan2(len, d2);
+    }
+}
+
+#if defined(VERTEXNORMALS_AVX2) || defined(VERTEXNORMALS_SSE2)
+
+#if defined(VERTEXNORMALS_AVX2)
+typedef __m256 Lane;
+const size_t laneWidth = 8;
+inline Lane add(Lane a, Lane b) { return _mm256_add_ps(a, b); }
+inline Lane sub(Lane a, Lane b) { return _mm256_sub_ps(a, b); }
+inline Lane mul(Lane a, Lane b) { return _mm256_mul_ps(a, b); }
+inline Lane laneSqrt(Lane a) { return _mm256_sqrt_ps(a); }
+inline Lane splat(float v) { return _mm256_set1_ps(v); }
+inline void store(float *out, Lane a) { _mm256_store_ps(out, a); }
+
+// 1 / len, or 0 where len is 0
+inline Lane safeInverse(Lane len) {
+    Lane nonZero = _mm256_cmp_ps(len, _mm256_setzero_ps(), _CMP_GT_OQ);
+    return _mm256_and_ps(nonZero, _mm256_div_ps(splat(1.0f), len));
+}
+
+// Corner 'corner' of faces f..f+7, gathered straight from the AoS positions
+inline void gatherCorner(const float *p, const unsigned int *idx, size_t f, int corner, Lane &x, Lane &y, Lane &z) {
+    const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    __m256i vertex = _mm256_i32gather_epi32(reinterpret_cast<const int *>(idx + 3 * f + corner), stride, 4);
+    __m256i offset = _mm256_add_epi32(vertex, _mm256_add_epi32(vertex, vertex));
+    x = _mm256_i32gather_ps(p, offset, 4);
+    y = _mm256_i32gather_ps(p + 1, offset, 4);
+    z = _mm256_i32gather_ps(p + 2, offset, 4);
+}
+
+// Writes eight face normals given as x, y and z lanes: a 4x4 transpose per half
+inline void storeFaceNormals(FaceNormal *out, Lane x, Lane y, Lane z) {
+    Lane w = _mm256_setzero_ps();
+    Lane xy0 = _mm256_unpacklo_ps(x, y), xy1 = _mm256_unpackhi_ps(x, y);
+    Lane zw0 = _mm256_unpacklo_ps(z, w), zw1 = _mm256_unpackhi_ps(z, w);
+    Lane r0 = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(1, 0, 1, 0));
+    Lane r1 = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(3, 2, 3, 2));
+    Lane r2 = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(1, 0, 1, 0));
+    Lane r3 = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(3, 2, 3, 2));
+    // Each 128-bit half now holds one face: r0 = faces 0 and 4, r1 = 1 and 5, ...
+    // (the array is only guaranteed 16-byte aligned, hence unaligned stores)
+    _mm256_storeu_ps(&out[0].x, _mm256_permute2f128_ps(r0, r1, 0x20));
+    _mm256_storeu_ps(&out[2].x, _mm256_permute2f128_ps(r2, r3, 0x20));
+    _mm256_storeu_ps(&out[4].x, _mm256_permute2f128_ps(r0, r1, 0x31));
+    _mm256_storeu_ps(&out[6].x, _mm256_permute2f128_ps(r2, r3, 0x31));
+}
+#else
+typedef __m128 Lane;
+const size_t laneWidth = 4;
+inline Lane add(Lane a, Lane b) { return _mm_add_ps(a, b); }
+inline Lane sub(Lane a, Lane b) { return _mm_sub_ps(a, b); }
+inline Lane mul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+inline Lane laneSqrt(Lane a) { return _mm_sqrt_ps(a); }
+inline Lane splat(float v) { return _mm_set1_ps(v); }
+inline void store(float *out, Lane a) { _mm_store_ps(out, a); }
+
+inline Lane safeInverse(Lane len) {
+    Lane nonZero = _mm_cmpgt_ps(len, _mm_setzero_ps());
+    return _mm_and_ps(nonZero, _mm_div_ps(splat(1.0f), len));
+}
+
+// SSE2 has no gather: assemble the lanes from four scalar loads each
+inline void gatherCorner(const float *p, const unsigned int *idx, size_t f, int corner, Lane &x, Lane &y, Lane &z) {
+    const float *v0 = p + 3 * size_t(idx[3 * f + corner]);
+    const float *v1 = p + 3 * size_t(idx[3 * f + 3 + corner]);
+    const float *v2 = p + 3 * size_t(idx[3 * f + 6 + corner]);
+    const float *v3 = p + 3 * size_t(idx[3 * f + 9 + corner]);
+    x = _mm_setr_ps(v0[0], v1[0], v2[0], v3[0]);
+    y = _mm_setr_ps(v0[1], v1[1], v2[1], v3[1]);
+    z = _mm_setr_ps(v0[2], v1[2], v2[2], v3[2]);
+}
+
+// Writes four face normals given as x, y and z lanes
+inline void storeFaceNormals(FaceNormal *out, Lane x, Lane y, Lane z) {
+    Lane w = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_store_ps(&out[0].x, x);
+    _mm_store_ps(&out[1].x, y);
+    _mm_store_ps(&out[2].x, z);
+    _mm_store_ps(&out[3].x, w);
+}
+#endif
+
+// laneWidth faces at once, starting at face f
+void faceNormalsSimd(const float *p, const unsigned int *idx, size_t f, NormalWeighting weighting, FaceNormal *out, float *cornerWeights) {
+    Lane ax, ay, az, bx, by, bz, cx, cy, cz;
+    gatherCorner(p, idx, f, 0, ax, ay, az);
+    gatherCorner(p, idx, f, 1, bx, by, bz);
+    gatherCorner(p, idx, f, 2, cx, cy, cz);
+
+    Lane e1x = sub(bx, ax), e1y = sub(by, ay), e1z = sub(bz, az);
+    Lane e2x = sub(cx, ax), e2y = sub(cy, ay), e2z = sub(cz, az);
+    Lane nx = sub(mul(e1y, e2z), mul(e2y, e1z));
+    Lane ny = sub(mul(e1z, e2x), mul(e2z, e1x));
+    Lane nz = sub(mul(e1x, e2y), mul(e2x, e1y));
+    Lane len = laneSqrt(add(add(mul(nx, nx), mul(ny, ny)), mul(nz, nz)));
+
+    if (weighting != NormalWeighting::Area) {
+        Lane scale = safeInverse(len);
+        nx = mul(nx, scale);
+        ny = mul(ny, scale);
+        nz = mul(nz, scale);
+    }
+
+    storeFaceNormals(out + f, nx, ny, nz);
+
+    if (weighting == NormalWeighting::Angle) {
+        Lane ex = sub(cx, bx), ey = sub(cy, by), ez = sub(cz, bz);
+        Lane d0 = add(add(mul(e1x, e2x), mul(e1y, e2y)), mul(e1z, e2z));
+        Lane d1 = sub(splat(0.0f), add(add(mul(e1x, ex), mul(e1y, ey)), mul(e1z, ez)));
+        Lane d2 = add(add(mul(e2x, ex), mul(e2y, ey)), mul(e2z, ez));
+        alignas(32) float sl[laneWidth], s0[laneWidth], s1[laneWidth], s2[laneWidth];
+        store(sl, len);
+        store(s0, d0);
+        store(s1, d1);
+        store(s2, d2);
+        for (size_t k = 0; k < laneWidth; k++) {
+            cornerWeights[3 * (f + k)] = std::atan2(sl[k], s0[k]);
+            cornerWeights[3 * (f + k) + 1] = std::atan2(sl[k], s1[k]);
+            cornerWeights[3 * (f + k) + 2] = std::atan2(sl[k], s2[k]);
+        }
+    }
+}
+
+#else
+const size_t laneWidth = 1;
+#endif
+
+// The gather only pays off when the pool's workers run beside the caller.
+// The shared pool always has a worker, for background jobs, even on a
+// single hardware thread.
+bool gatherRunsInParallel() {
+    return ThreadPool::shared().size() > 0 && std::thread::hardware_concurrency() != 1;
+}
+
+// Unit length, or zero if the sum vanished
+inline glm::vec3 normalizedSum(const float s[3]) {
+    float lengthSquared = s[0] * s[0] + s[1] * s[1] + s[2] * s[2];
+    float scale = (lengthSquared > 0.0f) ? 1.0f / std::sqrt(lengthSquared) : 0.0f;
+    return glm::vec3(s[0] * scale, s[1] * scale, s[2] * scale);
+}
+
+} // namespace
+
+void computeVertexNormalsScatter(
+    const std::vector<glm::vec3> &positions,
+    const std::vector<unsigned int> &indices,
+    std::vector<glm::vec3> &normals,
+    NormalWeighting weighting
+) {
+    const float *p = &positions.data()->x;
+    const unsigned int *idx = indices.data();
+    std::vector<glm::vec3> sums(positions.size(), glm::vec3(0.0f));
+    for (size_t f = 0; f < indices.size() / 3; f++) {
+        FaceNormal n;
+        float angles[3] = { 1.0f, 1.0f, 1.0f }; // Only overwritten in Angle mode
+        faceNormalScalar(p, idx, f, weighting, n, angles);
+        for (int corner = 0; corner < 3; corner++)
+            sums[idx[3 * f + corner]] += angles[corner] * glm::vec3(n.x, n.y, n.z);
+    }
+    normals.resize(positions.size());
+    for (size_t v = 0; v < sums.size(); v++)
+        normals[v] = normalizedSum(&sums[v].x);
+}
+
+void computeVertexNormals(
+    const std::vector<glm::vec3> &positions,
+    const std::vector<unsigned int> &indices,
+    std::vector<glm::vec3> &normals,
+    NormalWeighting weighting
+) {
+    if (!gatherRunsInParallel()) {
+        computeVertexNormalsScatter(positions, indices, normals, weighting);
+        return;
+    }
+    VertexCorners vertexCorners;
+    buildVertexCornerTable(indices, positions.size(), vertexCorners);
+    computeVertexNormalsGather(positions, indices, vertexCorners, normals, weighting);
+}
+
+void computeVertexNormals(
+    const std::vector<glm::vec3> &positions,
+    const std::vector<unsigned int> &indices,
+    const VertexCorners &vertexCorners,
+    std::vector<glm::vec3> &normals,
+    NormalWeighting weighting
+) {
+    if (!gatherRunsInParallel())
+        computeVertexNormalsScatter(positions, indices, normals, weighting);
+    else
+        computeVertexNormalsGather(positions, indices, vertexCorners, normals, weighting);
+}
+
+void computeVertexNormalsGather(
+    const std::vector<glm::vec3> &positions,
+    const std::vector<unsigned int> &indices,
+    const VertexCorners &vertexCorners,
+    std::vector<glm::vec3> &normals,
+    NormalWeighting weighting
+) {
+    ThreadPool &pool = ThreadPool::shared();
+    const size_t vertexCount = positions.size();
+    const size_t faceCount = indices.size() / 3;
+    const float *p = &positions.data()->x;
+    const unsigned int *idx = indices.data();
+
+    // Pass 1: one normal per face, laneWidth faces per SIMD step
+    std::vector<FaceNormal> faceNormals(faceCount);
+    std::vector<float> cornerWeights(weighting == NormalWeighting::Angle ? 3 * faceCount : 0);
+    pool.parallelFor(faceCount, grain, [&](size_t begin, size_t end) {
+        size_t f = begin;
+#if defined(VERTEXNORMALS_AVX2) || defined(VERTEXNORMALS_SSE2)
+        for (; f + laneWidth <= end; f += laneWidth)
+            faceNormalsSimd(p, idx, f, weighting, faceNormals.data(), cornerWeights.data());
+#endif
+        for (; f < end; f++)
+            faceNormalScalar(p, idx, f, weighting, faceNormals[f], weighting == NormalWeighting::Angle ? &cornerWeights[3 * f] : nullptr);
+    });
+
+    // Pass 2: every vertex sums its own faces, in corner order
+    const std::vector<unsigned int> &cornerOffsets = vertexCorners.offsets;
+    const std::vector<unsigned int> &corners = vertexCorners.corners;
+
+    normals.resize(vertexCount);
+    pool.parallelFor(vertexCount, grain, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+            float s[4];
+#if defined(VERTEXNORMALS_AVX2) || defined(VERTEXNORMALS_SSE2)
+            __m128 sum = _mm_setzero_ps();
+            for (unsigned int j = cornerOffsets[v]; j < cornerOffsets[v + 1]; j++) {
+                unsigned int c = corners[j];
+                __m128 n = _mm_load_ps(&faceNormals[c / 3].x);
+                if (weighting == NormalWeighting::Angle)
+                    n = _mm_mul_ps(n, _mm_set1_ps(cornerWeights[c]));
+                sum = _mm_add_ps(sum, n);
+            }
+            _mm_storeu_ps(s, sum);
+#else
+            s[0] = s[1] = s[2] = 0.0f;
+            for (unsigned int j = cornerOffsets[v]; j < cornerOffsets[v + 1]; j++) {
+                unsigned int c = corners[j];
+                float w = (weighting == NormalWeighting::Angle) ? cornerWeights[c] : 1.0f;
+                s[0] += w * faceNormals[c / 3].x;
+                s[1] += w * faceNormals[c / 3].y;
+                s[2] += w * faceNormals[c / 3].z;
+            }
+#endif
+            normals[v] = normalizedSum(s);
+        }
+    });
+}
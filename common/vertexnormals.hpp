@@ -0,0 +1,58 @@
+#ifndef VERTEXNORMALS_HPP
+#define VERTEXNORMALS_HPP
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "meshtopology.hpp"
+
+// How much each adjacent face contributes to a vertex normal.
+enum class NormalWeighting {
+    Uniform, // Every face counts the same (unit face normals)
+    Area,    // Larger faces count more
+    Angle    // Weighted by the face's corner angle at the vertex; independent of tessellation
+};
+
+// Smooth per-vertex normals of an indexed triangle mesh. Degenerate faces are
+// skipped; vertices without faces get a zero normal. Runs the parallel gather
+// below when ThreadPool::shared() has workers on other hardware threads, else
+// the serial scatter, which has about half the gather's memory traffic.
+void computeVertexNormals(
+    const std::vector<glm::vec3> &positions,
+    const std::vector<unsigned int> &indices,
+    std::vector<glm::vec3> &normals,
+    NormalWeighting weighting = NormalWeighting::Uniform
+);
+
+// Same, with the vertex-corner table of 'indices' already built. Callers that
+// recompute normals for moving vertices over fixed triangles keep one around.
+void computeVertexNormals(
+    const std::vector<glm::vec3> &positions,
+    const std::vector<unsigned int> &indices,
+    const VertexCorners &vertexCorners,
+    std::vector<glm::vec3> &normals,
+    NormalWeighting weighting = NormalWeighting::Uniform
+);
+
+// Face normals are computed with SIMD (AVX2 when the build enables it, else
+// SSE2), and each vertex then gathers its own faces, so threads never write
+// to shared data and the result does not depend on the thread count.
+void computeVertexNormalsGather(
+    const std::vector<glm::vec3> &positions,
+    const std::vector<unsigned int> &indices,
+    const VertexCorners &vertexCorners,
+    std::vector<glm::vec3> &normals,
+    NormalWeighting weighting = NormalWeighting::Uniform
+);
+
+// The reference: one face at a time adds its normal to its three vertices.
+// Each vertex sums its faces in the same order as in the gather.
+void computeVertexNormalsScatter(
+    const std::vector<glm::vec3> &positions,
+    const std::vector<unsigned int> &indices,
+    std::vector<glm::vec3> &normals,
+    NormalWeighting weighting = NormalWeighting::Uniform
+);
+
+#endif
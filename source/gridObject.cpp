@@ -1,7 +1,22 @@
 ﻿#include "gridObject.hpp"
 #include <glm/gtc/type_ptr.hpp>
+#include <common/vertexlayout.hpp>
 #include <vector>
 
+// Position loc 0, Color loc 1, interleaved
+typedef VertexLayout<FloatAttribute<0, glm::vec3>, FloatAttribute<1, glm::vec3>> GridLayout;
+
+// Append one line segment in a single color
+static void addLine(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& colors, std::vector<GLuint>& indices,
+                    const glm::vec3& a, const glm::vec3& b, const glm::vec3& color) {
+    indices.push_back(static_cast<GLuint>(positions.size()));
+    indices.push_back(static_cast<GLuint>(positions.size() + 1));
+    positions.push_back(a);
+    positions.push_back(b);
+    colors.push_back(color);
+    colors.push_back(color);
+}
+
 gridObject::gridObject() {
     modelMatrix = glm::mat4(1.0f);
 
@@ -10,44 +25,28 @@ gridObject::gridObject() {
     glGenBuffers(1, &EBO);
     glBindVertexArray(VAO);
 
-    std::vector<GLfloat> vertices;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> colors;
     std::vector<GLuint>  indices;
-    GLuint index = 0;
+    const glm::vec3 gray(0.5f);
 
     // Draw integer grid on Y=0 from (-5,-5) to (+5,+5)
-    for (int z = -5; z <= 5; ++z) {
-        vertices.insert(vertices.end(), { -5.0f, 0.0f, float(z),  0.5f,0.5f,0.5f });
-        vertices.insert(vertices.end(), { 5.0f, 0.0f, float(z),  0.5f,0.5f,0.5f });
-        indices.push_back(index++);
-        indices.push_back(index++);
-    }
-    for (int x = -5; x <= 5; ++x) {
-        vertices.insert(vertices.end(), { float(x), 0.0f, -5.0f,  0.5f,0.5f,0.5f });
-        vertices.insert(vertices.end(), { float(x), 0.0f,  5.0f,  0.5f,0.5f,0.5f });
-        indices.push_back(index++);
-        indices.push_back(index++);
-    }
+    for (int z = -5; z <= 5; ++z)
+        addLine(positions, colors, indices, glm::vec3(-5.0f, 0.0f, float(z)), glm::vec3(5.0f, 0.0f, float(z)), gray);
+    for (int x = -5; x <= 5; ++x)
+        addLine(positions, colors, indices, glm::vec3(float(x), 0.0f, -5.0f), glm::vec3(float(x), 0.0f, 5.0f), gray);
 
-    // Positive X axis (red)
-    vertices.insert(vertices.end(), { 0,0,0, 1,0,0 });
-    vertices.insert(vertices.end(), { 5,0,0, 1,0,0 });
-    indices.push_back(index++); indices.push_back(index++);
-    // Positive Y axis (green)
-    vertices.insert(vertices.end(), { 0,0,0, 0,1,0 });
-    vertices.insert(vertices.end(), { 0,5,0, 0,1,0 });
-    indices.push_back(index++); indices.push_back(index++);
-    // Positive Z axis (blue)
-    vertices.insert(vertices.end(), { 0,0,0, 0,0,1 });
-    vertices.insert(vertices.end(), { 0,0,5, 0,0,1 });
-    indices.push_back(index++); indices.push_back(index++);
+    // Positive X, Y and Z axes (red, green, blue)
+    addLine(positions, colors, indices, glm::vec3(0.0f), glm::vec3(5, 0, 0), glm::vec3(1, 0, 0));
+    addLine(positions, colors, indices, glm::vec3(0.0f), glm::vec3(0, 5, 0), glm::vec3(0, 1, 0));
+    addLine(positions, colors, indices, glm::vec3(0.0f), glm::vec3(0, 0, 5), glm::vec3(0, 0, 1));
 
     numIndices = static_cast<GLsizei>(indices.size());
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER,
-        vertices.size() * sizeof(GLfloat),
-        vertices.data(),
-        GL_STATIC_DRAW);
+    std::vector<unsigned char> vertices(positions.size() * GridLayout::stride);
+    GridLayout::pack(vertices.data(), positions.size(), PositionQuantization(), positions.data(), colors.data());
+    GridLayout::bind(VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size(), vertices.data(), GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER,
@@ -55,30 +54,35 @@ gridObject::gridObject() {
         indices.data(),
         GL_STATIC_DRAW);
 
-    // Position loc 0, Color loc 1
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
-
     glBindVertexArray(0);
-    shaderProgram = LoadShaders("gridVertexShader.glsl", "gridFragmentShader.glsl");
+    shaderProgram = AssetRegistry::shared().program("gridVertexShader.glsl", "gridFragmentShader.glsl");
+    if (shaderProgram) uniformMVP = shaderProgram->uniform("MVP");
 }
 
 gridObject::~gridObject() {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
-    glDeleteProgram(shaderProgram);
 }
 
-void gridObject::draw(const glm::mat4& view, const glm::mat4& projection) {
-    glUseProgram(shaderProgram);
-    glm::mat4 MVP = projection * view * modelMatrix;
-    GLuint   uniMVP = glGetUniformLocation(shaderProgram, "MVP");
-    glUniformMatrix4fv(uniMVP, 1, GL_FALSE, glm::value_ptr(MVP));
+DrawItem gridObject::makeDrawItem(const glm::mat4& view, const glm::mat4& projection) const {
+    DrawItem item;
+    item.program = shaderProgram.get();
+    item.vertexArray = VAO;
+    item.primitive = GL_LINES;
+    item.count = numIndices;
+    item.mvpHandle = uniformMVP;
+    item.mvp = projection * view * modelMatrix;
+    return item;
+}
 
-    glBindVertexArray(VAO);
-    glDrawElements(GL_LINES, numIndices, GL_UNSIGNED_INT, 0);
+void gridObject::draw(const glm::mat4& view, const glm::mat4& projection) {
+    if (!shaderProgram) return;
+    RenderState state;
+    RenderQueue::execute(makeDrawItem(view, projection), state);
     glBindVertexArray(0);
 }
+
+void gridObject::submit(RenderQueue& queue, const glm::mat4& view, const glm::mat4& projection) {
+    if (shaderProgram) queue.submit(makeDrawItem(view, projection));
+}
@@ -5,6 +5,9 @@
 #include <glm/glm.hpp>
 #include <GLFW/glfw3.h>
 #include <common/shader.hpp>
+#include <common/shaderprogram.hpp>
+#include <common/assetregistry.hpp>
+#include <common/renderqueue.hpp>
 
 class gridObject {
 public:
@@ -12,11 +15,15 @@ public:
     ~gridObject();
 
     void draw(const glm::mat4& view, const glm::mat4& projection);
+    void submit(RenderQueue& queue, const glm::mat4& view, const glm::mat4& projection);
 
 
 private:
+    DrawItem makeDrawItem(const glm::mat4& view, const glm::mat4& projection) const;
+
     GLuint VAO, VBO, EBO;
-    GLuint shaderProgram;
+    std::shared_ptr<ShaderProgram> shaderProgram; // From the AssetRegistry
+    int uniformMVP = -1;
     glm::mat4 modelMatrix;
 
     
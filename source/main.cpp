@@ -31,12 +31,13 @@ int main() {
 
     // Scene
     gridObject grid;
-    // Load the custom head model and texture
-    meshObject head("C:/Users/provi/Downloads/cg_project_1 (1)/cg_project_1/source/low_poly_head.obj", "C:/Users/provi/Downloads/cg_project_1 (1)/cg_project_1/source/head-filled-skylum.jpeg");
+    // Load the custom head model and texture in the background; it appears once uploaded
+    meshObject head("C:/Users/provi/Downloads/cg_project_1 (1)/cg_project_1/source/low_poly_head.obj", "C:/Users/provi/Downloads/cg_project_1 (1)/cg_project_1/source/head-filled-skylum.jpeg", meshObject::LoadMode::Async, VertexFormat::Packed);
     // Rotate the head to face the camera (assuming +Z is forward in model space and camera looks towards -Z)
     head.rotate(180.0f, glm::vec3(0.0f, 1.0f, 0.0f));
     // Optional: Translate slightly if needed, e.g., head.translate(glm::vec3(0.0f, -5.0f, 0.0f)); to lower it
-    head.setSubdivisionLevel(2); // Pre-calculate subdivision level 2
+    head.setAutoSubdivision(1.0f); // Smooth view picks its level from the head's size on screen, built on demand
+    head.setLodChain({ 0.5f, 0.25f, 0.125f }); // Simplified copies for when the head is small on screen
 
     // Camera state
     bool cameraSelected = false, cWasPressed = false;
@@ -44,6 +45,7 @@ int main() {
     bool fWasPressed = false; // Track 'F' key state for wireframe toggle
     bool pWasPressed = false; // Track 'P' key state for smooth toggle
     bool uWasPressed = false; // Track 'U' key state for texture toggle
+    bool lWasPressed = false; // Track 'L' key state for limit surface toggle
     float horizontalAngle = 0.0f;
     float verticalAngle = 0.0f;
     const float cameraSpeed = glm::radians(90.0f);  // 90°/sec
@@ -53,6 +55,11 @@ int main() {
     double lastFPSTime = lastFrameTime;
     int    nbFrames = 0;
 
+    // Draws are queued each frame and submitted sorted by state
+    RenderQueue renderQueue;
+    RenderState renderState;
+    RenderStats renderStats;
+
     while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
         !glfwWindowShouldClose(window))
     {
@@ -60,7 +67,8 @@ int main() {
         double currentTime = glfwGetTime();
         nbFrames++;
         if (currentTime - lastFPSTime >= 1.0) {
-            std::cout << 1000.0 / double(nbFrames) << " ms/frame\n";
+            std::cout << 1000.0 / double(nbFrames) << " ms/frame (" << renderStats.draws << " draws in " << renderStats.batches << " calls, "
+                      << renderStats.stateCalls << " state calls, " << renderStats.skippedCalls << " skipped)\n";
             nbFrames = 0;
             lastFPSTime += 1.0;
         }
@@ -107,6 +115,13 @@ int main() {
         }
         uWasPressed = uPressed;
 
+        // --- toggle limit surface projection with L ---
+        bool lPressed = (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS);
+        if (lPressed && !lWasPressed) {
+            head.toggleLimitSurface();
+        }
+        lWasPressed = lPressed;
+
         // --- when camera is ON, handle arrow keys ---
         if (cameraSelected) {
             if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
@@ -143,10 +158,14 @@ int main() {
             upDirection
         );
 
+        // --- finish background loads, a few ms of GL uploads per frame ---
+        meshObject::processPendingUploads(4.0);
+
         // --- render ---
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        grid.draw(viewMatrix, projectionMatrix);
-        head.draw(viewMatrix, projectionMatrix); // Draw the head model
+        grid.submit(renderQueue, viewMatrix, projectionMatrix);
+        head.submit(renderQueue, viewMatrix, projectionMatrix); // Draw the head model
+        renderStats = renderQueue.flush(renderState);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -0,0 +1,23 @@
+#version 330 core
+
+// Input vertex attributes (from VBO)
+layout(location = 0) in vec3 position; // Vertex position
+layout(location = 1) in vec2 vertexUV; // Texture coordinates
+
+// Per-instance attributes (from the instance buffer, one value per instance)
+layout(location = 3) in mat4 instanceModel; // Model matrix, locations 3-6
+
+// Output to fragment shader
+out vec2 UV;
+
+// Uniforms
+uniform mat4 VP; // Combined View-Projection matrix, shared by all instances
+
+
+void main() {
+    // Transform the vertex position by its instance's model matrix
+    gl_Position = VP * (instanceModel * vec4(position, 1.0));
+
+    // Pass UV coordinates to the fragment shader
+    UV = vertexUV;
+}
@@ -6,25 +6,268 @@
 #include <sstream>      // For parsing lines (loadOBJ)
 #include <string>       // For string manipulation
 #include <algorithm>    // For std::replace (if needed)
-#include <set>      // For Edge struct and subdivision logic
-#include <map>      // For vertex adjacency and edge midpoints
+#include <map>
+#include <atomic>   // For the background load job flags
+#include <chrono>   // For the per-frame upload budget
+#include <cmath>    // For HUGE_VAL (no upload deadline)
 
 // Define STB_IMAGE_IMPLEMENTATION in exactly one .cpp file
 #define STB_IMAGE_IMPLEMENTATION
 #include "../common/stb_image.h" // For texture loading
 #include "../common/objloader.hpp" // Include the common OBJ loader
+#include "../common/meshcache.hpp" // Compiled .meshbin cache in front of the OBJ loader
+#include "../common/threadpool.hpp" // Worker threads for async loading
+#include "../common/vertexnormals.hpp" // SIMD vertex normals
+#include "../common/meshsimplify.hpp" // Quadric-error simplification for the LOD chain
+#include "../common/mappedfile.hpp" // Texture bytes are hashed before decoding
 
 // Initialize static member
 int meshObject::nextId = 1;
 std::map<int, meshObject*> meshObject::meshObjectMap;
+std::vector<meshObject*> meshObject::loadingObjects;
+std::vector<meshObject*> meshObject::subdividingObjects;
+std::vector<meshObject*> meshObject::simplifyingObjects;
+std::vector<meshObject*> meshObject::projectingObjects;
+
+// Buffer data is streamed to GL in slices of this size, so one large mesh
+// cannot blow the per-frame upload budget on its own.
+static const size_t uploadSliceBytes = 1 << 20;
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct MipLevel {
+    int width, height;
+    std::vector<unsigned char> data;
+};
+
+// 2x2 box filter down to the next mip level (odd edges reuse the last row/column)
+static MipLevel downsample(const unsigned char* src, int width, int height, int components) {
+    MipLevel mip;
+    mip.width = std::max(1, width / 2);
+    mip.height = std::max(1, height / 2);
+    mip.data.resize(size_t(mip.width) * mip.height * components);
+    for (int y = 0; y < mip.height; ++y) {
+        const unsigned char* row0 = src + size_t(std::min(2 * y, height - 1)) * width * components;
+        const unsigned char* row1 = src + size_t(std::min(2 * y + 1, height - 1)) * width * components;
+        unsigned char* dst = &mip.data[size_t(y) * mip.width * components];
+        for (int x = 0; x < mip.width; ++x) {
+            int x0 = std::min(2 * x, width - 1) * components;
+            int x1 = std::min(2 * x + 1, width - 1) * components;
+            for (int c = 0; c < components; ++c)
+                dst[x * components + c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+        }
+    }
+    return mip;
+}
+
+// Builds the cached Loop levels up to 'level'. Only connectivity is involved,
+// so this runs once per level for the lifetime of the mesh. Stops early if
+// 'cancelled' gets set.
+static void buildSubdivisionLevels(LoopLevels& levels, int level, const std::vector<unsigned int>& baseIndices, size_t baseVertexCount, const std::atomic<bool>* cancelled = nullptr) {
+    while ((int)levels.size() < level && !(cancelled && *cancelled)) {
+        const std::vector<unsigned int>& coarseIndices = levels.empty() ? baseIndices : levels.back()->indices;
+        size_t coarseVertexCount = levels.empty() ? baseVertexCount : levels.back()->vertexCount();
+        std::shared_ptr<LoopLevel> next = std::make_shared<LoopLevel>();
+        VertexCacheStats before, after;
+        buildLoopLevel(coarseIndices, coarseVertexCount, *next, &before, &after);
+        levels.push_back(next);
+        std::cout << "Built subdivision level: " << levels.size() << " (vertex cache ACMR " << before.acmr << " -> " << after.acmr
+                  << ", ATVR " << before.atvr << " -> " << after.atvr << ")" << std::endl;
+    }
+}
+
+// Pushes vertex data of level 'fromLevel' through the cached stencils up to level 'toLevel'
+template <typename Vec>
+static void evaluateSubdivision(const LoopLevels& levels, int fromLevel, int toLevel, const std::vector<Vec>& coarseData, std::vector<Vec>& out) {
+    if (fromLevel == toLevel || coarseData.empty()) {
+        out = coarseData;
+        return;
+    }
+    std::vector<Vec> scratch;
+    const std::vector<Vec>* coarse = &coarseData;
+    for (int l = fromLevel; l < toLevel; ++l) {
+        // Alternate between the two arrays so the last level lands in 'out'
+        std::vector<Vec>& refined = ((toLevel - l) % 2 == 1) ? out : scratch;
+        applyStencils(levels[l]->stencils, *coarse, refined);
+        coarse = &refined;
+    }
+}
+
+// Height of the GL viewport in pixels
+static float viewportHeight() {
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    return static_cast<float>(viewport[3]);
+}
+
+// Largest scale factor along the axes of a model matrix
+static float maxScale(const glm::mat4& model) {
+    return std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+}
+
+// The six clip planes of a view-projection matrix, normalized, pointing inwards
+static void frustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]) {
+    glm::mat4 m = glm::transpose(viewProjection); // Rows of viewProjection
+    for (int axis = 0; axis < 3; ++axis) {
+        planes[2 * axis] = m[3] + m[axis];
+        planes[2 * axis + 1] = m[3] - m[axis];
+    }
+    for (int i = 0; i < 6; ++i)
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+}
+
+// Whether a sphere is at least partly inside all six planes
+static bool sphereInFrustum(const glm::vec4 planes[6], const glm::vec3& center, float radius) {
+    for (int i = 0; i < 6; ++i) {
+        if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) return false;
+    }
+    return true;
+}
+
+// Bounding sphere around the AABB center (not minimal, but cheap and stable)
+static void boundingSphere(const std::vector<glm::vec3>& vertices, glm::vec3& center, float& radius) {
+    center = glm::vec3(0.0f);
+    radius = 0.0f;
+    if (vertices.empty()) return;
+    glm::vec3 lower = vertices[0], upper = vertices[0];
+    for (const glm::vec3& v : vertices) {
+        lower = glm::min(lower, v);
+        upper = glm::max(upper, v);
+    }
+    center = 0.5f * (lower + upper);
+    float radiusSquared = 0.0f;
+    for (const glm::vec3& v : vertices)
+        radiusSquared = std::max(radiusSquared, glm::dot(v - center, v - center));
+    radius = std::sqrt(radiusSquared);
+}
+
+// Largest distance from a base vertex to its limit position. Each Loop step
+// halves the edge lengths and the distance to the limit goes with their
+// square, so level L is within about this / 4^L of the limit surface.
+static float limitSurfaceError(const std::vector<glm::vec3>& vertices, const std::vector<unsigned int>& indices, const VertexCorners& corners) {
+    LoopLimit limit;
+    buildLoopLimit(indices, vertices.size(), corners, limit);
+    std::vector<glm::vec3> limitVertices;
+    applyStencils(limit.positions, vertices, limitVertices);
+    float error = 0.0f;
+    for (size_t i = 0; i < vertices.size(); ++i)
+        error = std::max(error, glm::length(limitVertices[i] - vertices[i]));
+    return error;
+}
+
+// Content key of the base mesh in the asset registry (the same arrays in another format are another asset).
+// A second seed gives the registry's collision check.
+static uint64_t hashGeometry(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec2>& uvs, const std::vector<glm::vec3>& normals, const std::vector<unsigned int>& indices, VertexFormat format, uint64_t seed = 0) {
+    uint64_t parts[5] = {
+        hashBytes(vertices.data(), vertices.size() * sizeof(glm::vec3), seed),
+        hashBytes(uvs.data(), uvs.size() * sizeof(glm::vec2), seed),
+        hashBytes(normals.data(), normals.size() * sizeof(glm::vec3), seed),
+        hashBytes(indices.data(), indices.size() * sizeof(unsigned int), seed),
+        static_cast<uint64_t>(format)
+    };
+    return hashBytes(parts, sizeof(parts), seed);
+}
+
+static const uint64_t geometryCheckSeed = 0xD6E8FEB86659FD93ull;
+
+// Everything a load produces before touching GL. Owned jointly by the object
+// and the worker, so destroying a loading object never races with the worker.
+struct meshObject::LoadJob {
+    std::string modelPath;
+    std::string texturePath;
+    std::string textureKey; // Canonical texture path, the registry's key
+    bool decodeTexture = true; // False if a registered texture was found by path
+    std::atomic<bool> done{ false };
+    std::atomic<bool> cancelled{ false };
+    std::atomic<int> requestedSubdivisionLevel{ 0 };
+    std::atomic<bool> limitSurface{ false }; // Also project the smooth level onto the limit surface
+
+    bool meshLoaded = false;
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    std::vector<unsigned int> indices;
+    VertexCorners corners;
+    glm::vec3 boundingCenter = glm::vec3(0.0f);
+    float boundingRadius = 0.0f;
+    float limitError = 0.0f;
+    VertexFormat vertexFormat = VertexFormat::Separate;
+    PositionQuantization quantization;
+    uint64_t geometryHash = 0; // Of the four base arrays and the format
+    uint64_t geometryCheck = 0; // The same, under another seed
+
+    LoopLevels subdivisionLevels; // Stencils and faces per level, handed to the object
+    int subdivisionLevel = 0; // Level the smooth arrays were built for
+    std::vector<glm::vec3> smoothVertices;
+    std::vector<glm::vec2> smoothUvs;
+    std::vector<glm::vec3> smoothNormals;
+    LimitSurface smoothLimit; // Only filled if limitSurface was set in time
+
+    unsigned char* pixels = nullptr; // Decoded texture (mip level 0), freed once uploaded
+    uint64_t textureHash = 0; // Of the texture file's bytes
+    int width = 0, height = 0, components = 0;
+    std::vector<MipLevel> mipmaps; // Levels 1..n, built on the worker instead of glGenerateMipmap
+
+    ~LoadJob() {
+        if (pixels) stbi_image_free(pixels);
+    }
+};
+
+// One subdivision level being built off the GL thread. The worker only reads
+// and writes the job, which owns copies of (or shared references to) its inputs.
+struct meshObject::SubdivisionJob {
+    std::atomic<bool> done{ false };
+    std::atomic<bool> cancelled{ false }; // Superseded: the worker stops and the GL side does not switch
+    int level = 0;
+    int fromLevel = 0; // Level the input vertex data belongs to
+
+    LoopLevels levels; // Cached levels at submission; the worker appends what is missing
+    std::vector<unsigned int> baseIndices; // Only needed when no level is cached yet
+    size_t baseVertexCount = 0;
+
+    std::vector<glm::vec3> vertices; // In: fromLevel data. Out: the new level
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    std::atomic<bool> limitSurface{ false }; // Also project the new level onto the limit surface
+    LimitSurface limit;
+    bool uploading = false; // GL thread only
+};
+
+// An LOD chain being built off the GL thread, from copies of the base mesh
+struct meshObject::LodJob {
+    std::atomic<bool> done{ false };
+    std::vector<glm::vec3> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<size_t> targets; // Triangle counts, largest first
+    std::vector<LodLevel> levels; // Out: one per distinct triangle count reached
+    bool uploading = false; // GL thread only
+};
+
+// A resident level moved onto the limit surface, or back to its control
+// points, off the GL thread. The level keeps drawing its old data until the
+// new data has streamed into arena space of its own.
+struct meshObject::LimitJob {
+    std::atomic<bool> done{ false };
+    std::atomic<bool> cancelled{ false }; // Superseded: the worker skips the evaluation and nothing is swapped in
+    int level = 0;
+    bool project = false; // False goes back to the control points, which needs no worker
+
+    std::shared_ptr<const LoopLevel> topology;
+    std::vector<glm::vec3> vertices; // Control points of the level
+    std::vector<glm::vec2> uvs;
+    LimitSurface limit; // In: the level's masks, if built. Out: the projected level
+    ArenaRange range; // GL thread only: where the new data is uploaded to
+    bool uploading = false; // GL thread only
+};
 
 // Default constructor (can be removed or adapted if not needed)
 meshObject::meshObject() : id(nextId++) {
     meshObjectMap[id] = this;
     modelMatrix = glm::mat4(1.0f);
     // Initialize other members to default values if necessary
-    VAO = VBO_vertices = VBO_uvs = VBO_normals = EBO = 0;
-    shaderProgram = pickingShaderProgram = textureID = 0;
+    textureID = 0;
     numIndices = 0;
     showWireframe = false;
     std::cerr << "Warning: Default meshObject constructor called. No model loaded." << std::endl;
@@ -32,140 +275,608 @@ meshObject::meshObject() : id(nextId++) {
 }
 
 // Constructor to load model and texture
-meshObject::meshObject(const std::string& modelPath, const std::string& texturePath) : id(nextId++) {
+meshObject::meshObject(const std::string& modelPath, const std::string& texturePath, LoadMode mode, VertexFormat format) : id(nextId++) {
     meshObjectMap[id] = this;
     modelMatrix = glm::mat4(1.0f);
     showWireframe = false;
 
-    // Load mesh data using the common loader
-    bool res = loadOBJ(modelPath.c_str(), vertices, uvs, normals, indices);
-    if (!res) {
-        std::cerr << "Error loading OBJ file: " << modelPath << std::endl;
-        // Handle error appropriately (e.g., load default, throw exception)
-        return;
+    loadJob = std::make_shared<LoadJob>();
+    loadJob->modelPath = modelPath;
+    loadJob->texturePath = texturePath;
+    loadJob->vertexFormat = vertexFormat = format;
+    loadState = LoadState::Loading;
+
+    // A texture some other object already uploaded is neither read nor decoded again
+    loadJob->textureKey = AssetRegistry::canonicalPath(texturePath.c_str());
+    std::shared_ptr<TextureAsset> known = AssetRegistry::shared().findTexture(loadJob->textureKey);
+    if (known && known->ready) {
+        texture = known;
+        loadJob->decodeTexture = false;
     }
-    numIndices = static_cast<GLsizei>(indices.size()); // Update numIndices after loading
 
-    // Initialize smooth mesh data with base mesh data initially
-    smoothVertices = vertices;
-    smoothUvs = uvs;
-    smoothNormals = normals;
-    smoothIndices = indices;
-    numSmoothIndices = numIndices;
+    loadMode = mode;
+    if (mode == LoadMode::Async) {
+        std::shared_ptr<LoadJob> job = loadJob;
+        ThreadPool::shared().submit([job]() { runLoadJob(*job); });
+        loadingObjects.push_back(this);
+    } else {
+        runLoadJob(*loadJob);
+        advanceLoad(HUGE_VAL);
+    }
+}
 
-    // Load texture
-    textureID = loadTexture(texturePath);
-    if (textureID == 0) {
-        std::cerr << "Error loading texture file: " << texturePath << std::endl;
-        // Handle error (optional: proceed without texture)
+// Parses the model, decodes the texture and pre-builds the requested
+// subdivision level. Only touches the job, never the meshObject.
+void meshObject::runLoadJob(LoadJob& job) {
+    // Load mesh data using the common loader (through the compiled-mesh cache)
+    job.meshLoaded = loadOBJCached(job.modelPath.c_str(), job.vertices, job.uvs, job.normals, job.indices);
+
+    if (job.meshLoaded && !job.cancelled && job.decodeTexture) {
+        // stbi_set_flip_vertically_on_load(true); // Uncomment if texture appears upside down
+        MappedFile file;
+        if (file.open(job.texturePath.c_str())) {
+            job.textureHash = hashBytes(file.data(), file.size());
+            job.pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.data()), static_cast<int>(file.size()), &job.width, &job.height, &job.components, 0);
+        }
+        if (job.pixels) {
+            const unsigned char* level = job.pixels;
+            int width = job.width, height = job.height;
+            while (width > 1 || height > 1) {
+                job.mipmaps.push_back(downsample(level, width, height, job.components));
+                level = job.mipmaps.back().data.data();
+                width = job.mipmaps.back().width;
+                height = job.mipmaps.back().height;
+            }
+        }
     }
 
-    // Setup OpenGL buffers for original and smooth mesh
-    setupBuffers();
-    setupSmoothBuffers(); // Setup buffers for the (initially identical) smooth mesh
+    // What automatic level selection needs to know about the base mesh
+    if (job.meshLoaded && !job.cancelled) {
+        buildVertexCornerTable(job.indices, job.vertices.size(), job.corners);
+        boundingSphere(job.vertices, job.boundingCenter, job.boundingRadius);
+        job.limitError = limitSurfaceError(job.vertices, job.indices, job.corners);
+        job.quantization = PositionQuantization::fit(job.vertices.data(), job.vertices.size());
+        job.geometryHash = hashGeometry(job.vertices, job.uvs, job.normals, job.indices, job.vertexFormat);
+        job.geometryCheck = hashGeometry(job.vertices, job.uvs, job.normals, job.indices, job.vertexFormat, geometryCheckSeed);
+    }
+
+    int level = job.requestedSubdivisionLevel;
+    if (job.meshLoaded && !job.cancelled && level > 0) {
+        buildSubdivisionLevels(job.subdivisionLevels, level, job.indices, job.vertices.size(), &job.cancelled);
+        if (!job.cancelled) {
+            evaluateSubdivision(job.subdivisionLevels, 0, level, job.vertices, job.smoothVertices);
+            evaluateSubdivision(job.subdivisionLevels, 0, level, job.uvs, job.smoothUvs);
+            computeVertexNormals(job.smoothVertices, job.subdivisionLevels[level - 1]->indices, job.subdivisionLevels[level - 1]->corners, job.smoothNormals);
+            if (job.limitSurface)
+                job.smoothLimit.evaluate(*job.subdivisionLevels[level - 1], job.smoothVertices, job.smoothUvs);
+            job.subdivisionLevel = level;
+        }
+    }
 
-    // Load shaders (ensure these shaders handle textures)
-    shaderProgram = LoadShaders("meshVertexShader.glsl", "meshFragmentShader.glsl");
-    pickingShaderProgram = LoadShaders("pickingVertexShader.glsl", "pickingFragmentShader.glsl");
+    job.done = true;
 }
 
-meshObject::~meshObject() {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO_vertices);
-    glDeleteBuffers(1, &VBO_uvs);
-    glDeleteBuffers(1, &VBO_normals);
-    glDeleteBuffers(1, &EBO);
-    glDeleteVertexArrays(1, &smoothVAO); // Delete smooth buffers
-    glDeleteBuffers(1, &smoothVBO_vertices);
-    glDeleteBuffers(1, &smoothVBO_uvs);
-    glDeleteBuffers(1, &smoothVBO_normals);
-    glDeleteBuffers(1, &smoothEBO);
-    if (textureID != 0) {
-        glDeleteTextures(1, &textureID);
-    }
-    if (shaderProgram != 0) {
-        glDeleteProgram(shaderProgram);
-    }
-    if (pickingShaderProgram != 0) {
-        glDeleteProgram(pickingShaderProgram);
+// Builds any missing topology, then refines the job's vertex data up to its
+// level. Only touches the job, never the meshObject.
+void meshObject::runSubdivisionJob(SubdivisionJob& job) {
+    buildSubdivisionLevels(job.levels, job.level, job.baseIndices, job.baseVertexCount, &job.cancelled);
+    if (!job.cancelled) {
+        std::vector<glm::vec3> coarseVertices = std::move(job.vertices);
+        std::vector<glm::vec2> coarseUvs = std::move(job.uvs);
+        evaluateSubdivision(job.levels, job.fromLevel, job.level, coarseVertices, job.vertices);
+        evaluateSubdivision(job.levels, job.fromLevel, job.level, coarseUvs, job.uvs);
     }
-    meshObjectMap.erase(id);
+    if (!job.cancelled)
+        computeVertexNormals(job.vertices, job.levels[job.level - 1]->indices, job.levels[job.level - 1]->corners, job.normals);
+    if (!job.cancelled && job.limitSurface)
+        job.limit.evaluate(*job.levels[job.level - 1], job.vertices, job.uvs);
+    job.done = true;
 }
 
-void meshObject::draw(const glm::mat4& view, const glm::mat4& projection) {
-    if (shaderProgram == 0) return; // Don't draw if setup failed
-
-    GLuint currentVAO = showSmooth ? smoothVAO : VAO;
-    GLsizei currentNumIndices = showSmooth ? numSmoothIndices : numIndices;
-
-    if (currentVAO == 0) return; // Don't draw if the selected VAO is not ready
-
-    glUseProgram(shaderProgram);
-
-    // Set MVP matrix uniform
-    glm::mat4 MVP = projection * view * modelMatrix;
-    GLuint matrixID = glGetUniformLocation(shaderProgram, "MVP");
-    glUniformMatrix4fv(matrixID, 1, GL_FALSE, glm::value_ptr(MVP));
-
-    // Bind texture conditionally
-    if (showTexture && textureID != 0) {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        // Set the sampler to use texture unit 0
-        GLuint textureSamplerID = glGetUniformLocation(shaderProgram, "textureSampler");
-        glUniform1i(textureSamplerID, 0);
-        // Indicate texture is used (optional, depends on shader)
-        GLuint useTextureID = glGetUniformLocation(shaderProgram, "useTexture");
-        if (useTextureID != -1) glUniform1i(useTextureID, 1);
+// Simplifies the job's mesh down to each target. Targets that could not be
+// reached (everything left is a seam or boundary) give the same mesh as the
+// one before and are dropped. Only touches the job, never the meshObject.
+void meshObject::runLodJob(LodJob& job) {
+    double start = nowSeconds();
+    std::vector<std::vector<unsigned int>> chain;
+    std::vector<float> errors;
+    simplifyMeshChain(job.vertices, job.indices, job.targets, chain, errors);
+
+    size_t previousCount = job.indices.size();
+    for (size_t i = 0; i < chain.size(); ++i) {
+        if (chain[i].size() == previousCount) continue;
+        previousCount = chain[i].size();
+        LodLevel level;
+        level.indices = std::move(chain[i]);
+        level.error = errors[i];
+        job.levels.push_back(std::move(level));
+    }
+
+    std::cout << "LOD chain (" << (nowSeconds() - start) * 1000.0 << " ms):";
+    for (const LodLevel& level : job.levels) std::cout << " " << level.indices.size() / 3 << " tris (error " << level.error << ")";
+    std::cout << std::endl;
+    job.done = true;
+}
+
+void meshObject::processPendingUploads(double budgetMs) {
+    double deadline = nowSeconds() + budgetMs / 1000.0;
+    AssetRegistry::shared().collect(); // Nothing from the last frame is in use any more
+    for (size_t i = 0; i < loadingObjects.size();) {
+        meshObject* object = loadingObjects[i];
+        if (object->advanceLoad(deadline)) {
+            loadingObjects.erase(loadingObjects.begin() + i); // Ready or failed
+        } else {
+            ++i;
+        }
+        if (nowSeconds() >= deadline) return;
+    }
+    for (size_t i = 0; i < subdividingObjects.size();) {
+        meshObject* object = subdividingObjects[i];
+        if (object->advanceSubdivision(deadline)) {
+            subdividingObjects.erase(subdividingObjects.begin() + i); // Swapped in or dropped
+            object->setSubdivisionLevel(object->requestedSubdivisionLevel); // Catch up with a level asked for meanwhile
+        } else {
+            ++i;
+        }
+        if (nowSeconds() >= deadline) return;
+    }
+    for (size_t i = 0; i < simplifyingObjects.size();) {
+        meshObject* object = simplifyingObjects[i];
+        if (object->advanceLodChain(deadline)) {
+            simplifyingObjects.erase(simplifyingObjects.begin() + i); // Swapped in
+        } else {
+            ++i;
+        }
+        if (nowSeconds() >= deadline) return;
+    }
+    for (size_t i = 0; i < projectingObjects.size();) {
+        meshObject* object = projectingObjects[i];
+        if (object->advanceLimitJob(deadline)) {
+            projectingObjects.erase(projectingObjects.begin() + i); // Swapped in
+            object->syncLimitSurface(); // Catch up with a toggle or level switch made meanwhile
+        } else {
+            ++i;
+        }
+        if (nowSeconds() >= deadline) return;
+    }
+}
+
+// Takes over a finished subdivision job, streams its buffers within the
+// deadline and, once they are complete, swaps the new level in. Returns true
+// when the job is finished with.
+bool meshObject::advanceSubdivision(double deadline) {
+    SubdivisionJob& job = *subdivisionJob;
+    if (!job.uploading) {
+        if (!job.done) return false;
+        if (job.cancelled) {
+            subdivisionJob.reset();
+            return true;
+        }
+
+        // Adopt the topology the worker built
+        for (size_t l = subdivisionLevels.size(); l < job.levels.size(); ++l)
+            subdivisionLevels.push_back(job.levels[l]);
+
+        SmoothLevel& smooth = smoothLevels[job.level];
+        smooth.vertices = std::move(job.vertices);
+        smooth.uvs = std::move(job.uvs);
+        smooth.normals = std::move(job.normals);
+        smooth.limit = std::move(job.limit);
+        smooth.lastUsed = ++smoothUseCounter;
+        if (!showLimitSurface) smooth.limit.clear(); // Toggled off while the worker ran; toggled on is caught up below
+        setupSmoothBuffers(smooth, job.level);
+        job.uploading = true;
+    }
+
+    if (!streamUploads(deadline)) return false;
+
+    // Everything is on the GPU: swap, unless a different level was asked for meanwhile
+    // (the level stays resident either way)
+    smoothLevels[job.level].lastUsed = ++smoothUseCounter;
+    if (!job.cancelled) subdivisionLevel = job.level;
+    evictSmoothLevels(subdivisionLevel);
+    subdivisionJob.reset();
+    syncLimitSurface(); // The toggle may have changed during the upload
+    return true;
+}
+
+// Hands the build of a non-resident level to a worker thread. The current
+// level keeps drawing until processPendingUploads swaps the new one in.
+void meshObject::startSubdivisionJob(int level) {
+    std::shared_ptr<SubdivisionJob> job = std::make_shared<SubdivisionJob>();
+    job->level = level;
+    job->levels = subdivisionLevels;
+    if (subdivisionLevels.empty()) job->baseIndices = indices;
+    job->baseVertexCount = vertices.size();
+    job->limitSurface = showLimitSurface;
+
+    // Refine from the closest resident level below, or from the base mesh
+    auto lower = smoothLevels.lower_bound(level);
+    if (lower != smoothLevels.begin()) {
+        --lower;
+        job->fromLevel = lower->first;
+        job->vertices = lower->second.vertices;
+        job->uvs = lower->second.uvs;
     } else {
-        // Indicate texture is not used (optional, depends on shader)
-        GLuint useTextureID = glGetUniformLocation(shaderProgram, "useTexture");
-        if (useTextureID != -1) glUniform1i(useTextureID, 0);
+        job->vertices = vertices;
+        job->uvs = uvs;
     }
 
-    // Set wireframe mode if toggled (applies to whichever mesh is drawn)
-    if (showWireframe) {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    subdivisionJob = job;
+    if (loadMode == LoadMode::Async) {
+        subdividingObjects.push_back(this);
+        ThreadPool::shared().submit([job]() { runSubdivisionJob(*job); });
+    } else {
+        runSubdivisionJob(*job);
+        advanceSubdivision(HUGE_VAL);
     }
+}
 
-    // Draw the selected mesh (original or smooth)
-    glBindVertexArray(currentVAO);
-    glDrawElements(GL_TRIANGLES, currentNumIndices, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+// Stops a job that has not been swapped in yet. A worker still running it
+// drops its results; one already uploading finishes as a resident level.
+void meshObject::cancelSubdivisionJob() {
+    if (!subdivisionJob) return;
+    subdivisionJob->cancelled = true;
+    if (!subdivisionJob->uploading) {
+        subdivisionJob.reset();
+        subdividingObjects.erase(std::remove(subdividingObjects.begin(), subdividingObjects.end(), this), subdividingObjects.end());
+    }
+}
+
+// Runs the GL side of loading as a sequence of small steps. At least one step
+// is taken per call so that loading always makes progress. Returns true once
+// the object is ready (or has failed).
+bool meshObject::advanceLoad(double deadline) {
+    bool firstStep = true;
+    while (isLoading() && (firstStep || nowSeconds() < deadline)) {
+        firstStep = false;
+        switch (uploadStage) {
+        case 0: { // Wait for the worker, then take over its results
+            if (!loadJob->done) return false;
+            if (!loadJob->meshLoaded) {
+                std::cerr << "Error loading OBJ file: " << loadJob->modelPath << std::endl;
+                loadState = LoadState::Failed;
+                loadJob.reset();
+                return true;
+            }
+            vertices = std::move(loadJob->vertices);
+            uvs = std::move(loadJob->uvs);
+            normals = std::move(loadJob->normals);
+            indices = std::move(loadJob->indices);
+            numIndices = static_cast<GLsizei>(indices.size()); // Update numIndices after loading
+            baseCorners = std::move(loadJob->corners);
+            boundingCenter = loadJob->boundingCenter;
+            boundingRadius = loadJob->boundingRadius;
+            limitError = loadJob->limitError;
+            quantization = loadJob->quantization;
+
+            subdivisionLevels = std::move(loadJob->subdivisionLevels);
+            subdivisionLevel = requestedSubdivisionLevel = loadJob->subdivisionLevel;
+            if (subdivisionLevel > 0) {
+                // Becomes the first resident level of the subdivision pyramid
+                SmoothLevel& smooth = smoothLevels[subdivisionLevel];
+                smooth.vertices = std::move(loadJob->smoothVertices);
+                smooth.uvs = std::move(loadJob->smoothUvs);
+                smooth.normals = std::move(loadJob->smoothNormals);
+                smooth.limit = std::move(loadJob->smoothLimit);
+                smooth.lastUsed = ++smoothUseCounter;
+                if (!showLimitSurface) smooth.limit.clear(); // Toggled off in time; toggled on too late is caught up once ready
+            }
+            loadState = LoadState::Uploading;
+            uploadStage++;
+            break;
+        }
+        case 1: // Load texture, or share one that is already uploaded
+            if (!acquireTexture(*loadJob)) return false; // Another object is still uploading it
+            textureID = texture ? texture->texture : 0;
+            if (textureID == 0) {
+                std::cerr << "Error loading texture file: " << loadJob->texturePath << std::endl;
+                // Handle error (optional: proceed without texture)
+            }
+            uploadStage++;
+            break;
+        case 2: // Setup OpenGL buffers for original and smooth mesh
+            if (!acquireGeometry(*loadJob)) return false; // Same for the base buffers
+            setupBuffers();
+            if (subdivisionLevel > 0) setupSmoothBuffers(smoothLevels[subdivisionLevel], subdivisionLevel);
+            uploadStage++;
+            break;
+        case 3: // Stream the texture and vertex data in slices
+            if (streamUploads(deadline)) {
+                // Others may draw from them now
+                if (texture) texture->ready = true;
+                geometry->ready = true;
+                uploadStage++;
+            }
+            break;
+        case 4: // Load shaders (ensure these shaders handle textures); compiled once for all objects
+            shaderProgram = AssetRegistry::shared().program("meshVertexShader.glsl", "meshFragmentShader.glsl");
+            if (shaderProgram) {
+                uniformMVP = shaderProgram->uniform("MVP");
+                uniformTextureSampler = shaderProgram->uniform("textureSampler");
+                uniformUseTexture = shaderProgram->uniform("useTexture");
+            }
+            uploadStage++;
+            break;
+        case 5:
+            pickingShaderProgram = AssetRegistry::shared().program("pickingVertexShader.glsl", "pickingFragmentShader.glsl");
+            if (pickingShaderProgram) {
+                pickingUniformMVP = pickingShaderProgram->uniform("MVP");
+                pickingUniformColor = pickingShaderProgram->uniform("pickingColor");
+            }
+            loadJob.reset();
+            loadState = LoadState::Ready;
+            // Catch up with a level requested after the worker had started subdividing
+            if (pendingSubdivisionLevel >= 0) {
+                int level = pendingSubdivisionLevel;
+                pendingSubdivisionLevel = -1;
+                setSubdivisionLevel(level);
+            }
+            if (!lodRatios.empty()) startLodJob(); // Asked for before the mesh was there
+            syncLimitSurface(); // Toggled on after the worker had passed the projection
+            break;
+        }
+    }
+    return !isLoading();
+}
+
+meshObject::~meshObject() {
+    if (isLoading()) {
+        if (loadJob) loadJob->cancelled = true; // The worker drops its results
+        loadingObjects.erase(std::remove(loadingObjects.begin(), loadingObjects.end(), this), loadingObjects.end());
+    }
+    if (subdivisionJob) {
+        subdivisionJob->cancelled = true;
+        subdividingObjects.erase(std::remove(subdividingObjects.begin(), subdividingObjects.end(), this), subdividingObjects.end());
+    }
+    if (lodJob) simplifyingObjects.erase(std::remove(simplifyingObjects.begin(), simplifyingObjects.end(), this), simplifyingObjects.end());
+    if (limitJob) {
+        limitJob->cancelled = true;
+        projectingObjects.erase(std::remove(projectingObjects.begin(), projectingObjects.end(), this), projectingObjects.end());
+        if (limitJob->uploading) GeometryArena::shared().release(limitJob->range);
+    }
+    releaseLodLevels();
+    if (lodJob && lodJob->uploading) releaseLodRanges(lodJob->levels);
+
+    // The base mesh, texture and programs go back to the registry
+    glDeleteBuffers(1, &instanceBuffer);
+    for (const Instance& instance : instances) meshObjectMap.erase(instance.id);
+    for (auto& entry : smoothLevels) releaseSmoothLevel(entry.second); // Delete smooth buffers
+    meshObjectMap.erase(id);
+}
 
-    // Reset polygon mode to fill for other objects
-    if (showWireframe) {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+// Picks what to draw this frame (switching levels as needed) and the state it takes
+bool meshObject::prepareDraw(const glm::mat4& view, const glm::mat4& projection, DrawItem& item) {
+    if (!isReady() || !shaderProgram) return false; // Don't draw while loading or if setup failed
+
+    // Automatic level: switches (and builds, if needed) only when the on-screen error asks for it
+    if (showSmooth && autoSubdivisionPixelError > 0.0f) {
+        int level = pickSubdivisionLevel(view, projection);
+        if (level != requestedSubdivisionLevel) setSubdivisionLevel(level);
     }
 
+    // Level 0 of the smooth view is the base mesh itself
+    const ArenaRange* current = geometry ? &geometry->range : nullptr;
+    if (showSmooth && subdivisionLevel > 0) {
+        auto it = smoothLevels.find(subdivisionLevel);
+        current = (it != smoothLevels.end()) ? &it->second.range : nullptr;
+    } else if (!lodLevels.empty()) {
+        // The base mesh may be drawn from a simplified copy while it is small on screen
+        lodLevel = pickLodLevel(modelMatrix, view, projection, viewportHeight(), lodLevel);
+        if (lodLevel > 0) current = &lodLevels[lodLevel - 1].range;
+    }
+
+    if (!current || !current->valid()) return false; // Don't draw if the selected mesh is not ready
+
+    item.program = shaderProgram.get();
+    item.vertexArray = GeometryArena::shared().block(*current).vertexArray;
+    item.baseVertex = static_cast<GLint>(current->baseVertex);
+    item.firstIndex = current->firstIndex;
+    item.count = static_cast<GLsizei>(current->indexCount);
+    item.primitive = GL_TRIANGLES;
+    item.polygonMode = showWireframe ? GL_LINE : GL_FILL; // Applies to whichever mesh is drawn
+
+    // MVP goes through the program's handle (unchanged values are not re-sent)
+    item.mvpHandle = uniformMVP;
+    glm::mat4 modelViewProjection = projection * view * modelMatrix;
+    item.mvp = modelViewProjection * positionDecode();
+    glm::vec4 center = modelViewProjection * glm::vec4(boundingCenter, 1.0f);
+    item.depth = (center.w > 0.0f) ? center.z / center.w : 1.0f;
+
+    // Bind texture conditionally, sampled from texture unit 0
+    bool textured = showTexture && textureID != 0;
+    item.texture = textured ? textureID : 0;
+    item.integers[0] = { uniformTextureSampler, 0 };
+    item.integers[1] = { uniformUseTexture, textured ? 1 : 0 }; // Indicate whether the texture is used
+    return true;
+}
+
+glm::mat4 meshObject::positionDecode() const {
+    return (vertexFormat == VertexFormat::Packed) ? quantization.decode() : glm::mat4(1.0f);
+}
+
+void meshObject::submit(RenderQueue& queue, const glm::mat4& view, const glm::mat4& projection) {
+    DrawItem item;
+    if (prepareDraw(view, projection, item)) queue.submit(item);
+}
+
+void meshObject::draw(const glm::mat4& view, const glm::mat4& projection) {
+    DrawItem item;
+    if (!prepareDraw(view, projection, item)) return;
+
+    RenderState state; // Nothing is assumed about what is bound
+    RenderQueue::execute(item, state);
+
+    // Leave the defaults other code expects
+    state.polygonMode(GL_FILL);
+    glBindVertexArray(0);
     glUseProgram(0); // Unbind shader program
-    if (showTexture && textureID != 0) {
+    if (item.texture != 0) {
         glBindTexture(GL_TEXTURE_2D, 0); // Unbind texture only if it was bound
     }
 }
 
 void meshObject::drawPicking(const glm::mat4& view, const glm::mat4& projection) {
     // Picking usually uses the base mesh for simplicity and consistency
-    if (pickingShaderProgram == 0 || VAO == 0) return;
+    if (!isReady() || !pickingShaderProgram || !geometry) return;
 
-    glUseProgram(pickingShaderProgram);
-    glm::mat4 MVP = projection * view * modelMatrix;
-    GLuint matrixID = glGetUniformLocation(pickingShaderProgram, "MVP");
-    glUniformMatrix4fv(matrixID, 1, GL_FALSE, glm::value_ptr(MVP));
+    pickingShaderProgram->use();
+    glm::mat4 MVP = projection * view * modelMatrix * positionDecode();
+    pickingShaderProgram->set(pickingUniformMVP, MVP);
 
     // TODO: send 'id' as a uniform for color‐coded picking
-    GLuint pickingColorID = glGetUniformLocation(pickingShaderProgram, "pickingColor");
     float r = (id & 0xFF) / 255.0f;
     float g = ((id >> 8) & 0xFF) / 255.0f;
     float b = ((id >> 16) & 0xFF) / 255.0f;
-    glUniform4f(pickingColorID, r, g, b, 1.0f);
+    pickingShaderProgram->set(pickingUniformColor, glm::vec4(r, g, b, 1.0f));
 
-    glBindVertexArray(VAO); // Use base mesh VAO for picking
-    glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, 0); // Use base mesh indices
+    const ArenaRange& range = geometry->range; // Use the base mesh for picking
+    glBindVertexArray(GeometryArena::shared().block(range).vertexArray);
+    glDrawElementsBaseVertex(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, range.indexOffset(), range.baseVertex);
     glBindVertexArray(0);
     glUseProgram(0);
 }
 
+int meshObject::addInstance(const glm::mat4& model) {
+    int instanceId = nextId++; // From the same counter, so picking IDs never clash
+    meshObjectMap[instanceId] = this;
+    instanceSlots[instanceId] = instances.size();
+    instances.push_back({ model, instanceId, 0, false });
+    return instanceId;
+}
+
+void meshObject::setInstanceTransform(int instanceId, const glm::mat4& model) {
+    auto slot = instanceSlots.find(instanceId);
+    if (slot != instanceSlots.end()) instances[slot->second].model = model;
+}
+
+void meshObject::removeInstance(int instanceId) {
+    auto slot = instanceSlots.find(instanceId);
+    if (slot == instanceSlots.end()) return;
+    // The last instance takes the freed slot
+    size_t index = slot->second;
+    instances[index] = instances.back();
+    instanceSlots[instances[index].id] = index;
+    instances.pop_back();
+    instanceSlots.erase(instanceId);
+    meshObjectMap.erase(instanceId);
+}
+
+// Drops the instances outside the view frustum, picks an LOD for each of the
+// others (if levels > 1) and uploads them to the instance buffer, grouped by
+// LOD. Element l of the result is where level l starts; the last is the total.
+std::vector<size_t> meshObject::gatherInstances(const glm::mat4& view, const glm::mat4& projection, int levels) {
+    glm::vec4 planes[6];
+    frustumPlanes(projection * view, planes);
+    float height = viewportHeight();
+
+    std::vector<size_t> levelStarts(levels + 1, 0);
+    for (Instance& instance : instances) {
+        glm::vec3 center = glm::vec3(instance.model * glm::vec4(boundingCenter, 1.0f));
+        instance.visible = sphereInFrustum(planes, center, boundingRadius * maxScale(instance.model));
+        if (!instance.visible) continue;
+        instance.lodLevel = (levels > 1) ? pickLodLevel(instance.model, view, projection, height, instance.lodLevel) : 0;
+        levelStarts[instance.lodLevel + 1]++;
+    }
+    for (int l = 0; l < levels; ++l) levelStarts[l + 1] += levelStarts[l];
+
+    instanceData.resize(levelStarts[levels]);
+    std::vector<size_t> next(levelStarts.begin(), levelStarts.end() - 1);
+    glm::mat4 decode = positionDecode();
+    for (const Instance& instance : instances) {
+        if (instance.visible) instanceData[next[instance.lodLevel]++] = { instance.model * decode, static_cast<float>(instance.id) };
+    }
+
+    // Orphan the storage each frame so the driver need not wait for last frame's draws
+    size_t bytes = instanceData.size() * sizeof(InstanceData);
+    if (instanceBuffer == 0) glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    if (bytes > instanceBufferBytes) instanceBufferBytes = std::max(bytes, 2 * instanceBufferBytes);
+    glBufferData(GL_ARRAY_BUFFER, instanceBufferBytes, nullptr, GL_STREAM_DRAW);
+    if (bytes > 0) glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instanceData.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return levelStarts;
+}
+
+// There is no base instance in OpenGL 3.3, so each LOD group re-points the
+// attributes at its first instance instead
+void meshObject::bindInstanceAttributes(size_t firstInstance, bool enable) {
+    static_assert(InstanceLayout::stride == sizeof(InstanceData), "InstanceLayout must describe InstanceData");
+    if (enable) {
+        InstanceLayout::bind(instanceBuffer, firstInstance * InstanceLayout::stride, 1);
+    } else {
+        InstanceLayout::disable(); // Left enabled, they would be fetched by the other shaders' draws
+    }
+}
+
+void meshObject::drawInstances(const glm::mat4& view, const glm::mat4& projection) {
+    visibleInstances = 0;
+    if (!isReady() || instances.empty() || !geometry) return;
+    if (!instancedShaderProgram) {
+        instancedShaderProgram = AssetRegistry::shared().program("meshInstancedVertexShader.glsl", "meshFragmentShader.glsl");
+        if (!instancedShaderProgram) return;
+        instancedUniformVP = instancedShaderProgram->uniform("VP");
+        instancedUniformTextureSampler = instancedShaderProgram->uniform("textureSampler");
+        instancedUniformUseTexture = instancedShaderProgram->uniform("useTexture");
+    }
+
+    // The smooth view draws every instance at the current level; otherwise each picks its LOD
+    auto smooth = smoothLevels.find(subdivisionLevel);
+    bool drawSmooth = showSmooth && subdivisionLevel > 0 && smooth != smoothLevels.end() && smooth->second.range.valid();
+    int levels = drawSmooth ? 1 : static_cast<int>(lodLevels.size()) + 1;
+    std::vector<size_t> levelStarts = gatherInstances(view, projection, levels);
+    visibleInstances = levelStarts.back();
+    if (visibleInstances == 0) return;
+
+    RenderState state;
+    state.useProgram(instancedShaderProgram->id());
+    instancedShaderProgram->set(instancedUniformVP, projection * view);
+    bool textured = showTexture && textureID != 0;
+    if (textured) state.bindTexture(textureID);
+    instancedShaderProgram->set(instancedUniformTextureSampler, 0);
+    instancedShaderProgram->set(instancedUniformUseTexture, textured ? 1 : 0);
+    state.polygonMode(showWireframe ? GL_LINE : GL_FILL);
+
+    for (int l = 0; l < levels; ++l) {
+        GLsizei count = static_cast<GLsizei>(levelStarts[l + 1] - levelStarts[l]);
+        if (count == 0) continue;
+        const ArenaRange& range = drawSmooth ? smooth->second.range : (l == 0 ? geometry->range : lodLevels[l - 1].range);
+        glBindVertexArray(GeometryArena::shared().block(range).vertexArray);
+        bindInstanceAttributes(levelStarts[l], true);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(range.indexCount), GL_UNSIGNED_INT, range.indexOffset(), count, range.baseVertex);
+        bindInstanceAttributes(0, false); // The VAO is shared with every mesh in the block
+    }
+
+    state.polygonMode(GL_FILL);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
+    if (textured) glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void meshObject::drawInstancesPicking(const glm::mat4& view, const glm::mat4& projection) {
+    if (!isReady() || instances.empty() || !geometry) return;
+    if (!pickingInstancedShaderProgram) {
+        pickingInstancedShaderProgram = AssetRegistry::shared().program("pickingInstancedVertexShader.glsl", "pickingInstancedFragmentShader.glsl");
+        if (!pickingInstancedShaderProgram) return;
+        pickingInstancedUniformVP = pickingInstancedShaderProgram->uniform("VP");
+    }
+
+    std::vector<size_t> levelStarts = gatherInstances(view, projection, 1); // Base mesh only, like drawPicking
+    if (levelStarts.back() == 0) return;
+
+    pickingInstancedShaderProgram->use();
+    pickingInstancedShaderProgram->set(pickingInstancedUniformVP, projection * view);
+    const ArenaRange& range = geometry->range;
+    glBindVertexArray(GeometryArena::shared().block(range).vertexArray);
+    bindInstanceAttributes(0, true);
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, range.indexOffset(), static_cast<GLsizei>(levelStarts.back()), range.baseVertex);
+    bindInstanceAttributes(0, false);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
+}
+
 void meshObject::translate(const glm::vec3& translation) {
     modelMatrix = glm::translate(modelMatrix, translation);
 }
@@ -186,7 +897,7 @@ void meshObject::toggleWireframe() {
 void meshObject::toggleSmooth() {
     showSmooth = !showSmooth;
     std::cout << "Smooth Shading Toggled: " << (showSmooth ? "ON" : "OFF") << std::endl;
-    if (showSmooth && subdivisionLevel < targetSubdivisionLevel) {
+    if (showSmooth && autoSubdivisionPixelError <= 0.0f && subdivisionLevel < targetSubdivisionLevel) {
         setSubdivisionLevel(targetSubdivisionLevel); // Apply subdivision if needed
     }
 }
@@ -196,359 +907,580 @@ void meshObject::toggleTexture() {
     std::cout << "Texture Mapping Toggled: " << (showTexture ? "ON" : "OFF") << std::endl;
 }
 
+void meshObject::toggleLimitSurface() {
+    showLimitSurface = !showLimitSurface;
+    std::cout << "Limit Surface Toggled: " << (showLimitSurface ? "ON" : "OFF") << std::endl;
+    if (isLoading()) {
+        if (loadJob) loadJob->limitSurface = showLimitSurface; // Picked up by the worker if it is not past it yet
+        return;
+    }
+    if (subdivisionJob && !subdivisionJob->uploading) subdivisionJob->limitSurface = showLimitSurface; // Read by the worker only at the end; corrected on swap-in otherwise
+
+    // Only the level being drawn changes now; other resident levels follow when switched to
+    syncLimitSurface();
+}
+
 void meshObject::setSubdivisionLevel(int level) {
     if (level < 0) level = 0;
+    if (isLoading()) {
+        // Picked up by the worker if it has not subdivided yet, and applied on completion otherwise
+        pendingSubdivisionLevel = level;
+        if (loadJob) loadJob->requestedSubdivisionLevel = level;
+        return;
+    }
+    requestedSubdivisionLevel = level;
+    if (subdivisionJob) {
+        if (subdivisionJob->level == level && !subdivisionJob->cancelled) return; // Already on its way
+        if (subdivisionJob->uploading) {
+            // Let the upload finish; advanceSubdivision comes back for the new level
+            subdivisionJob->cancelled = true;
+            return;
+        }
+        cancelSubdivisionJob();
+    }
     if (level == subdivisionLevel) return; // No change needed
 
     std::cout << "Setting subdivision level to: " << level << std::endl;
 
-    // Reset to base mesh if needed
-    if (level < subdivisionLevel) {
-        smoothVertices = vertices;
-        smoothUvs = uvs;
-        smoothNormals = normals;
-        smoothIndices = indices;
-        subdivisionLevel = 0;
-    }
-
-    // Apply subdivision iteratively
-    while (subdivisionLevel < level) {
-        applyLoopSubdivision();
-        subdivisionLevel++;
-        std::cout << "Applied subdivision level: " << subdivisionLevel << std::endl;
+    // Resident levels are switched to directly; others are built in the background
+    auto resident = smoothLevels.find(level);
+    if (level == 0 || resident != smoothLevels.end()) {
+        subdivisionLevel = level;
+        if (level > 0) {
+            resident->second.lastUsed = ++smoothUseCounter;
+            syncLimitSurface();
+            evictSmoothLevels(level);
+        }
+        return;
     }
+    startSubdivisionJob(level);
+}
 
-    // Recalculate normals for the final subdivided mesh
-    calculateNormals(smoothVertices, smoothIndices, smoothNormals);
+void meshObject::setSubdivisionCacheBudget(size_t bytes) {
+    smoothCacheBudget = bytes;
+    evictSmoothLevels(subdivisionLevel);
+}
 
-    // Update smooth buffers with the new data
-    numSmoothIndices = static_cast<GLsizei>(smoothIndices.size());
-    setupSmoothBuffers(); // Re-setup buffers with new data
+void meshObject::setAutoSubdivision(float pixelError, int maxLevel) {
+    autoSubdivisionPixelError = pixelError;
+    autoSubdivisionMaxLevel = std::max(0, maxLevel);
 }
 
+// Pixels per model unit at the bounding sphere's nearest point, for the
+// object placed by 'model' (projection[1][1] is cot(fovy / 2))
+float meshObject::pixelsPerUnit(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, float viewportHeight) const {
+    glm::mat4 modelView = view * model;
+    float scale = maxScale(model);
+    float radius = boundingRadius * scale;
+    float distance = glm::length(glm::vec3(modelView * glm::vec4(boundingCenter, 1.0f)));
+    float depth = std::max(distance - radius, 0.1f * radius);
+    if (depth <= 0.0f) return 0.0f;
+    return scale * projection[1][1] * 0.5f * viewportHeight / depth;
+}
 
-// --- Private Helper Functions ---
+// Smallest level whose distance to the limit surface, seen from the camera at
+// the nearest point of the bounding sphere, is within the pixel threshold.
+// Going up happens as soon as the error exceeds the threshold; coming back
+// down waits until the lower level would be well inside it, so an object
+// hovering around a boundary does not flip between levels every frame.
+int meshObject::pickSubdivisionLevel(const glm::mat4& view, const glm::mat4& projection) const {
+    const float hysteresis = 0.5f;
+    if (limitError <= 0.0f) return 0; // Flat: every level lies on the limit surface already
+
+    float basePixels = limitError * pixelsPerUnit(modelMatrix, view, projection, viewportHeight());
+    auto pixels = [&](int level) { return basePixels / float(1 << (2 * level)); };
+
+    int level = std::min(std::max(requestedSubdivisionLevel, 0), autoSubdivisionMaxLevel);
+    while (level < autoSubdivisionMaxLevel && pixels(level) > autoSubdivisionPixelError) ++level;
+    while (level > 0 && pixels(level - 1) <= hysteresis * autoSubdivisionPixelError) --level;
+    return level;
+}
 
-// The custom loadOBJ function is removed as we now use the one from common/objloader.hpp
+void meshObject::setLodChain(const std::vector<float>& ratios, float pixelError) {
+    lodRatios = ratios;
+    lodPixelError = pixelError;
+    if (isLoading()) return; // Built once the mesh is there
+    if (isReady()) startLodJob();
+}
 
-// Texture loading using stb_image
-GLuint meshObject::loadTexture(const std::string& path) {
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    // stbi_set_flip_vertically_on_load(true); // Uncomment if texture appears upside down
-    unsigned char *data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-        else {
-            std::cerr << "Unknown number of components in texture: " << path << std::endl;
-            stbi_image_free(data);
-            glDeleteTextures(1, &textureID);
-            return 0;
-        }
+// Coarsest LOD whose simplification error, seen from the camera at the
+// nearest point of the bounding sphere, is within the pixel threshold. Same
+// hysteresis as the subdivision levels: a coarser LOD is only taken once it
+// would be well inside the threshold. 'current' is the LOD drawn last frame.
+int meshObject::pickLodLevel(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, float viewportHeight, int current) const {
+    const float hysteresis = 0.5f;
+    float scale = pixelsPerUnit(model, view, projection, viewportHeight);
+    int count = static_cast<int>(lodLevels.size());
+    auto pixels = [&](int level) { return (level > 0) ? lodLevels[level - 1].error * scale : 0.0f; };
+
+    int level = std::min(current, count);
+    while (level > 0 && pixels(level) > lodPixelError) --level;
+    while (level < count && pixels(level + 1) <= hysteresis * lodPixelError) ++level;
+    return level;
+}
 
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+// Simplifies the base mesh to each of lodRatios. The current chain keeps
+// drawing until processPendingUploads swaps the new one in.
+void meshObject::startLodJob() {
+    // A chain still uploading points into its job; finish it before dropping the job
+    if (lodJob && lodJob->uploading) advanceLodChain(HUGE_VAL);
+    simplifyingObjects.erase(std::remove(simplifyingObjects.begin(), simplifyingObjects.end(), this), simplifyingObjects.end());
+    lodJob.reset(); // A worker still running keeps its own reference and finishes unseen
 
-        // Set texture wrapping and filtering options
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (lodRatios.empty()) {
+        releaseLodLevels();
+        return;
+    }
 
-        stbi_image_free(data);
+    std::shared_ptr<LodJob> job = std::make_shared<LodJob>();
+    job->vertices = vertices;
+    job->indices = indices;
+    size_t triangles = indices.size() / 3;
+    for (float ratio : lodRatios)
+        job->targets.push_back(static_cast<size_t>(std::max(0.0f, ratio) * triangles));
+
+    lodJob = job;
+    if (loadMode == LoadMode::Async) {
+        simplifyingObjects.push_back(this);
+        ThreadPool::shared().submit([job]() { runLodJob(*job); });
     } else {
-        std::cerr << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data); // data is likely null here anyway, but safe to call
-        glDeleteTextures(1, &textureID);
-        return 0;
+        runLodJob(*job);
+        advanceLodChain(HUGE_VAL);
     }
-
-    glBindTexture(GL_TEXTURE_2D, 0); // Unbind texture
-    return textureID;
 }
 
-// Setup VAO, VBOs, EBO for the base mesh
-void meshObject::setupBuffers() {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO_vertices);
-    glGenBuffers(1, &VBO_uvs);
-    glGenBuffers(1, &VBO_normals);
-    glGenBuffers(1, &EBO);
+// Takes over a finished LOD job, places each level's triangles next to the
+// base vertices and swaps the chain in once they are uploaded. Returns true
+// when the job is finished with.
+bool meshObject::advanceLodChain(double deadline) {
+    LodJob& job = *lodJob;
+    if (!job.uploading) {
+        if (!job.done) return false;
+        placeLodLevels(job.levels);
+        job.uploading = true;
+    }
+
+    if (!streamUploads(deadline)) return false;
 
-    glBindVertexArray(VAO);
-
-    // Load data into vertex buffers
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_vertices);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+    releaseLodLevels();
+    lodLevels.swap(job.levels); // The element data moves along with its vectors
+    lodJob.reset();
+    return true;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_uvs);
-    glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(glm::vec2), uvs.data(), GL_STATIC_DRAW);
+void meshObject::releaseLodLevels() {
+    releaseLodRanges(lodLevels);
+    lodLevels.clear();
+    lodLevel = 0;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_normals);
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
+void meshObject::releaseLodRanges(std::vector<LodLevel>& levels) {
+    for (LodLevel& level : levels) GeometryArena::shared().release(level.range);
+}
 
-    // Load data into element buffer
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+// LOD triangles are drawn with the base mesh's base vertex, so they must be
+// in its block. A level that does not fit there is dropped.
+bool meshObject::placeLodLevels(std::vector<LodLevel>& levels) {
+    bool placedAll = true;
+    for (size_t i = 0; i < levels.size();) {
+        LodLevel& level = levels[i];
+        level.range = GeometryArena::shared().allocateIndices(geometry->range, level.indices.size());
+        if (!level.range.valid()) {
+            std::cerr << "No room for LOD " << i + 1 << " next to its base mesh; dropped" << std::endl;
+            levels.erase(levels.begin() + i);
+            placedAll = false;
+            continue;
+        }
+        queueRangeData(level.range, nullptr, nullptr, nullptr, &level.indices);
+        ++i;
+    }
+    return placedAll;
+}
 
-    // Set the vertex attribute pointers
-    // Vertex Positions (location = 0)
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_vertices);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-    glEnableVertexAttribArray(0);
+void meshObject::setBasePositions(const std::vector<glm::vec3>& positions) {
+    if (!isReady() || positions.size() != vertices.size()) return;
 
-    // Vertex Texture Coords (location = 1)
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_uvs);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
-    glEnableVertexAttribArray(1);
+    // Finish an upload in flight; a level still being built used the old
+    // positions and is started again at the end
+    if (subdivisionJob && subdivisionJob->uploading) {
+        advanceSubdivision(HUGE_VAL);
+        subdividingObjects.erase(std::remove(subdividingObjects.begin(), subdividingObjects.end(), this), subdividingObjects.end());
+    }
+    cancelSubdivisionJob();
+    if (limitJob && limitJob->uploading) {
+        advanceLimitJob(HUGE_VAL);
+        projectingObjects.erase(std::remove(projectingObjects.begin(), projectingObjects.end(), this), projectingObjects.end());
+    }
+    cancelLimitJob(); // Started again below, from the new positions
+
+    vertices = positions;
+    computeVertexNormals(vertices, indices, baseCorners, normals);
+    boundingSphere(vertices, boundingCenter, boundingRadius); // limitError is left as measured at load
+    quantization = PositionQuantization::fit(vertices.data(), vertices.size());
+    detachGeometry(); // Other objects drawing the same mesh keep the old one
+    bool packed = vertexFormat == VertexFormat::Packed; // Packed vertices are written whole
+    queueRangeData(geometry->range, &vertices, packed ? &uvs : nullptr, &normals, nullptr);
+
+    // Other resident levels are stale now; drop them and rebuild them on demand
+    for (auto it = smoothLevels.begin(); it != smoothLevels.end();) {
+        if (it->first == subdivisionLevel) {
+            ++it;
+            continue;
+        }
+        releaseSmoothLevel(it->second);
+        it = smoothLevels.erase(it);
+    }
 
-    // Vertex Normals (location = 2)
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_normals);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-    glEnableVertexAttribArray(2);
+    // Topology, faces and UVs are unchanged; only positions and normals are re-evaluated
+    auto current = smoothLevels.find(subdivisionLevel);
+    if (current != smoothLevels.end()) {
+        SmoothLevel& smooth = current->second;
+        evaluateSubdivision(subdivisionLevels, 0, subdivisionLevel, vertices, smooth.vertices);
+        const LoopLevel& level = *subdivisionLevels[subdivisionLevel - 1];
+        computeVertexNormals(smooth.vertices, level.indices, level.corners, smooth.normals);
+        if (!smooth.limit.empty()) smooth.limit.evaluate(level, smooth.vertices, smooth.uvs);
+        queueSmoothVertexData(smooth);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    streamUploads(HUGE_VAL);
 
-    glBindVertexArray(0); // Unbind VAO
+    syncLimitSurface();
+    if (requestedSubdivisionLevel != subdivisionLevel) setSubdivisionLevel(requestedSubdivisionLevel);
 }
 
 
-// Setup VAO, VBOs, EBO for the smooth (subdivided) mesh
-void meshObject::setupSmoothBuffers() {
-    // Clean up existing buffers if they exist
-    if (smoothVAO != 0) glDeleteVertexArrays(1, &smoothVAO);
-    if (smoothVBO_vertices != 0) glDeleteBuffers(1, &smoothVBO_vertices);
-    if (smoothVBO_uvs != 0) glDeleteBuffers(1, &smoothVBO_uvs);
-    if (smoothVBO_normals != 0) glDeleteBuffers(1, &smoothVBO_normals);
-    if (smoothEBO != 0) glDeleteBuffers(1, &smoothEBO);
-
-    glGenVertexArrays(1, &smoothVAO);
-    glBindVertexArray(smoothVAO);
+// --- Private Helper Functions ---
 
-    // Vertex Buffer
-    glGenBuffers(1, &smoothVBO_vertices);
-    glBindBuffer(GL_ARRAY_BUFFER, smoothVBO_vertices);
-    glBufferData(GL_ARRAY_BUFFER, smoothVertices.size() * sizeof(glm::vec3), smoothVertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-    glEnableVertexAttribArray(0);
+// The custom loadOBJ function is removed as we now use the one from common/objloader.hpp
 
-    // UV Buffer
-    if (!smoothUvs.empty()) {
-        glGenBuffers(1, &smoothVBO_uvs);
-        glBindBuffer(GL_ARRAY_BUFFER, smoothVBO_uvs);
-        glBufferData(GL_ARRAY_BUFFER, smoothUvs.size() * sizeof(glm::vec2), smoothUvs.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-        glEnableVertexAttribArray(1);
+// Takes the registered texture with the same file contents if it is uploaded.
+// One still being uploaded by an async object is waited for (returns false)
+// rather than uploaded twice; blocking loads cannot wait and make their own.
+bool meshObject::acquireTexture(LoadJob& job) {
+    if (texture) return true; // Found by path in the constructor
+    if (!job.pixels) {
+        std::cerr << "Texture failed to load at path: " << job.texturePath << std::endl;
+        return true;
     }
-
-    // Normal Buffer
-    if (!smoothNormals.empty()) {
-        glGenBuffers(1, &smoothVBO_normals);
-        glBindBuffer(GL_ARRAY_BUFFER, smoothVBO_normals);
-        glBufferData(GL_ARRAY_BUFFER, smoothNormals.size() * sizeof(glm::vec3), smoothNormals.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-        glEnableVertexAttribArray(2);
+    AssetRegistry& registry = AssetRegistry::shared();
+    std::shared_ptr<TextureAsset> shared = registry.findTexture(job.textureHash);
+    if (shared && shared->ready) {
+        texture = shared;
+        return true;
     }
+    if (shared && loadMode == LoadMode::Async) return false;
 
-    // Element Buffer
-    glGenBuffers(1, &smoothEBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, smoothEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, smoothIndices.size() * sizeof(unsigned int), smoothIndices.data(), GL_STATIC_DRAW);
+    std::shared_ptr<TextureAsset> created = registry.createTexture(job.textureKey, job.textureHash);
+    if (setupTexture(job, created->texture)) texture = created;
+    return true;
+}
 
-    glBindVertexArray(0); // Unbind VAO
+// Same for the base mesh, matched on two hashes of all four arrays
+bool meshObject::acquireGeometry(LoadJob& job) {
+    AssetRegistry& registry = AssetRegistry::shared();
+    std::shared_ptr<GeometryAsset> shared = registry.findGeometry(job.geometryHash, job.geometryCheck, vertices.size(), indices.size());
+    if (shared && !shared->ready && loadMode == LoadMode::Async) return false;
+    geometry = (shared && shared->ready) ? shared : registry.createGeometry(job.geometryHash, job.geometryCheck, vertices.size(), indices.size(), vertexFormat);
+    return true;
 }
 
-// Calculate vertex normals based on face normals
-void meshObject::calculateNormals(std::vector<glm::vec3>& verts, const std::vector<unsigned int>& inds, std::vector<glm::vec3>& norms) {
-    norms.assign(verts.size(), glm::vec3(0.0f)); // Initialize normals to zero
+// Gives the base mesh arena space nobody else uses, before it is changed.
+// The sole holder of a registered mesh just takes it off the registry;
+// otherwise UVs and triangles are copied into new space and the LODs move
+// along (they must share its block). Positions and normals are left to the
+// caller, which is about to upload new ones.
+void meshObject::detachGeometry() {
+    AssetRegistry& registry = AssetRegistry::shared();
+    if (!geometry || !geometry->registered) return; // Private already
+    if (geometry.use_count() == 1) {
+        registry.unregister(*geometry);
+        return;
+    }
 
-    for (size_t i = 0; i < inds.size(); i += 3) {
-        unsigned int i0 = inds[i];
-        unsigned int i1 = inds[i + 1];
-        unsigned int i2 = inds[i + 2];
+    streamUploads(HUGE_VAL); // Nothing may still be on its way into the LOD space freed below
+    geometry = registry.createPrivateGeometry(vertices.size(), indices.size(), vertexFormat);
+    geometry->ready = true;
+    queueRangeData(geometry->range, nullptr, &uvs, nullptr, &indices);
+    releaseLodRanges(lodLevels);
+    if (!placeLodLevels(lodLevels)) lodLevel = 0;
+    if (lodJob && lodJob->uploading) {
+        releaseLodRanges(lodJob->levels);
+        placeLodLevels(lodJob->levels);
+    }
+}
 
-        glm::vec3 v0 = verts[i0];
-        glm::vec3 v1 = verts[i1];
-        glm::vec3 v2 = verts[i2];
+// Set up the GL texture 'textureName' for the pixels stb_image decoded on the
+// worker and queue every mip level for streaming
+bool meshObject::setupTexture(LoadJob& job, GLuint textureName) {
+
+    GLenum format;
+    if (job.components == 1)
+        format = GL_RED;
+    else if (job.components == 3)
+        format = GL_RGB;
+    else if (job.components == 4)
+        format = GL_RGBA;
+    else {
+        std::cerr << "Unknown number of components in texture: " << job.texturePath << std::endl;
+        return false;
+    }
 
-        glm::vec3 edge1 = v1 - v0;
-        glm::vec3 edge2 = v2 - v0;
-        glm::vec3 faceNormal = glm::normalize(glm::cross(edge1, edge2));
+    glBindTexture(GL_TEXTURE_2D, textureName);
 
-        // Accumulate face normal onto vertex normals
-        norms[i0] += faceNormal;
-        norms[i1] += faceNormal;
-        norms[i2] += faceNormal;
+    // Every level is allocated and filled later, in streamUploads
+    size_t components = static_cast<size_t>(job.components);
+    textureUploads.push_back({ textureName, 0, job.width, job.height, format, job.pixels, job.width * components, 0, false });
+    for (size_t i = 0; i < job.mipmaps.size(); ++i) {
+        const MipLevel& mip = job.mipmaps[i];
+        GLint level = static_cast<GLint>(i + 1);
+        textureUploads.push_back({ textureName, level, mip.width, mip.height, format, mip.data.data(), mip.width * components, 0, false });
     }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(job.mipmaps.size()));
 
-    // Normalize all vertex normals
-    for (glm::vec3& normal : norms) {
-        normal = glm::normalize(normal);
-    }
+    // Set texture wrapping and filtering options
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glBindTexture(GL_TEXTURE_2D, 0); // Unbind texture
+    return true;
+}
+
+// Queue data for streaming into part of a buffer, starting 'destination' bytes in
+void meshObject::queueBufferSubData(GLuint buffer, size_t destination, const void* data, size_t size) {
+    if (size > 0) bufferUploads.push_back({ buffer, data, size, 0, destination });
 }
 
-// Apply one level of Loop subdivision
-void meshObject::applyLoopSubdivision() {
-    std::vector<glm::vec3> nextVertices;
-    std::vector<glm::vec2> nextUvs;
-    std::vector<unsigned int> nextIndices;
+// Queue the given arrays for streaming into the arena space of 'range'; null arrays are left as they are.
+// Packed vertices are written whole, so only along with positions (from all three arrays).
+void meshObject::queueRangeData(const ArenaRange& range, const std::vector<glm::vec3>* positions, const std::vector<glm::vec2>* uvs,
+                                const std::vector<glm::vec3>* normals, const std::vector<unsigned int>* triangles) {
+    const GeometryArena::Block& block = GeometryArena::shared().block(range);
+    if (block.format == VertexFormat::Packed) {
+        if (positions) {
+            std::vector<unsigned char> packed(positions->size() * PackedLayout::stride);
+            PackedLayout::pack(packed.data(), positions->size(), quantization, positions->data(),
+                               (normals && !normals->empty()) ? normals->data() : nullptr, (uvs && !uvs->empty()) ? uvs->data() : nullptr);
+            queueBufferSubData(block.vertices, range.baseVertex * PackedLayout::stride, packed.data(), packed.size());
+            packedStaging.push_back(std::move(packed)); // The upload reads it in place
+        }
+        if (triangles) queueBufferSubData(block.indices, range.firstIndex * sizeof(unsigned int), triangles->data(), triangles->size() * sizeof(unsigned int));
+        return;
+    }
+    // Separate streams store the arrays as they are
+    if (positions) queueBufferSubData(block.positions, range.baseVertex * PositionStream::stride, positions->data(), positions->size() * PositionStream::stride);
+    if (uvs) queueBufferSubData(block.uvs, range.baseVertex * UvStream::stride, uvs->data(), uvs->size() * UvStream::stride);
+    if (normals) queueBufferSubData(block.normals, range.baseVertex * NormalStream::stride, normals->data(), normals->size() * NormalStream::stride);
+    if (triangles) queueBufferSubData(block.indices, range.firstIndex * sizeof(unsigned int), triangles->data(), triangles->size() * sizeof(unsigned int));
+}
 
-    const size_t originalVertexCount = smoothVertices.size();
-    nextVertices.resize(originalVertexCount); // Pre-allocate space for updated original vertices
-    nextUvs.resize(originalVertexCount);
+// Upload queued texture rows and buffer data slice by slice; returns true once everything is uploaded
+bool meshObject::streamUploads(double deadline) {
+    bool firstSlice = true;
+    if (!textureUploads.empty()) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // stb_image rows are tightly packed
+        while (!textureUploads.empty() && (firstSlice || nowSeconds() < deadline)) {
+            firstSlice = false;
+            TextureUpload& upload = textureUploads.front();
+            glBindTexture(GL_TEXTURE_2D, upload.texture);
+            if (!upload.allocated) {
+                // Allocating a large level can be a step of its own
+                glTexImage2D(GL_TEXTURE_2D, upload.level, upload.format, upload.width, upload.height, 0, upload.format, GL_UNSIGNED_BYTE, nullptr);
+                upload.allocated = true;
+                if (nowSeconds() >= deadline) break;
+            }
+            GLsizei rows = static_cast<GLsizei>(std::max<size_t>(1, uploadSliceBytes / upload.rowBytes));
+            rows = std::min(rows, upload.height - upload.rowsDone);
+            glTexSubImage2D(GL_TEXTURE_2D, upload.level, 0, upload.rowsDone, upload.width, rows, upload.format, GL_UNSIGNED_BYTE,
+                            upload.data + upload.rowsDone * upload.rowBytes);
+            upload.rowsDone += rows;
+            if (upload.rowsDone == upload.height) textureUploads.erase(textureUploads.begin());
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
 
-    // --- Precomputation: Adjacency and Boundary Info ---
-    std::map<Edge, std::vector<unsigned int>> edgeOppositeVertices; // Edge -> opposite vertex(es)
-    std::map<Edge, int> edgeFaceCount;                          // Edge -> number of faces it belongs to
-    std::map<unsigned int, std::set<unsigned int>> vertexNeighbors; // Vertex -> adjacent vertices
-    std::map<Edge, unsigned int> edgeMidpointIndices;             // Edge -> index of the new midpoint vertex
+    while (textureUploads.empty() && !bufferUploads.empty() && (firstSlice || nowSeconds() < deadline)) {
+        firstSlice = false;
+        BufferUpload& upload = bufferUploads.front();
+        size_t bytes = std::min(uploadSliceBytes, upload.size - upload.offset);
+        // Element buffers are bound through the VAO, so upload everything via GL_COPY_WRITE_BUFFER
+        glBindBuffer(GL_COPY_WRITE_BUFFER, upload.buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, upload.destination + upload.offset, bytes, static_cast<const char*>(upload.data) + upload.offset);
+        upload.offset += bytes;
+        if (upload.offset == upload.size) bufferUploads.erase(bufferUploads.begin());
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (bufferUploads.empty()) packedStaging.clear();
+    return textureUploads.empty() && bufferUploads.empty();
+}
 
-    // Build adjacency, edge face counts, and opposite vertices
-    for (size_t i = 0; i < smoothIndices.size(); i += 3) {
-        unsigned int v[3] = { smoothIndices[i], smoothIndices[i + 1], smoothIndices[i + 2] };
+// Fill the arena space acquireGeometry picked, unless it is shared and already filled
+void meshObject::setupBuffers() {
+    if (!geometry->ready) {
+        // Streamed in by streamUploads
+        queueRangeData(geometry->range, &vertices, &uvs, &normals, &indices);
+    }
+}
 
-        for (int j = 0; j < 3; ++j) {
-            unsigned int v0 = v[j];
-            unsigned int v1 = v[(j + 1) % 3];
-            unsigned int v_opposite = v[(j + 2) % 3];
-            Edge edge = {v0, v1};
+// Bytes a resident level holds: CPU arrays plus their GL copies and the element buffer
+size_t meshObject::SmoothLevel::bytes(size_t indexCount, VertexFormat format) const {
+    size_t arrayBytes = vertices.size() * sizeof(glm::vec3) + uvs.size() * sizeof(glm::vec2) + normals.size() * sizeof(glm::vec3);
+    size_t limitBytes = (limit.vertices.size() + limit.normals.size()) * sizeof(glm::vec3) + limit.uvs.size() * sizeof(glm::vec2);
+    const StencilTable* tables[3] = { &limit.masks.positions, &limit.masks.tangents[0], &limit.masks.tangents[1] };
+    for (const StencilTable* table : tables)
+        limitBytes += table->offsets.size() * sizeof(unsigned int) + table->sources.size() * (sizeof(unsigned int) + sizeof(float));
+    return arrayBytes + vertices.size() * vertexBytes(format) + limitBytes + indexCount * sizeof(unsigned int);
+}
 
-            edgeFaceCount[edge]++;
-            edgeOppositeVertices[edge].push_back(v_opposite);
+// Triangles of a subdivision level (level 0 is the base mesh)
+const std::vector<unsigned int>& meshObject::levelIndices(int level) const {
+    return (level > 0) ? subdivisionLevels[level - 1]->indices : indices;
+}
 
-            vertexNeighbors[v0].insert(v1);
-            vertexNeighbors[v1].insert(v0);
+// Drops least recently used levels until the pyramid fits its budget. The
+// level in use is never dropped, even if it alone is over budget, and neither
+// is one a limit job is working on or a subdivision job is still uploading.
+void meshObject::evictSmoothLevels(int keepLevel) {
+    size_t total = 0;
+    for (const auto& entry : smoothLevels)
+        total += entry.second.bytes(levelIndices(entry.first).size(), vertexFormat);
+
+    while (total > smoothCacheBudget) {
+        auto victim = smoothLevels.end();
+        for (auto it = smoothLevels.begin(); it != smoothLevels.end(); ++it) {
+            bool busy = it->first == keepLevel || (limitJob && it->first == limitJob->level) ||
+                        (subdivisionJob && subdivisionJob->uploading && it->first == subdivisionJob->level);
+            if (!busy && (victim == smoothLevels.end() || it->second.lastUsed < victim->second.lastUsed))
+                victim = it;
         }
+        if (victim == smoothLevels.end()) break;
+
+        std::cout << "Evicting subdivision level: " << victim->first << std::endl;
+        total -= victim->second.bytes(levelIndices(victim->first).size(), vertexFormat);
+        releaseSmoothLevel(victim->second);
+        smoothLevels.erase(victim);
     }
+}
 
-    std::set<Edge> boundaryEdges;
-    std::set<unsigned int> boundaryVertices;
-    for(const auto& pair : edgeFaceCount) {
-        if (pair.second == 1) {
-            boundaryEdges.insert(pair.first);
-            boundaryVertices.insert(pair.first.v1);
-            boundaryVertices.insert(pair.first.v2);
-        }
+void meshObject::releaseSmoothLevel(SmoothLevel& smooth) {
+    GeometryArena::shared().release(smooth.range);
+}
+
+// Pushes a level's control points onto the limit surface, building the masks first if needed
+void meshObject::LimitSurface::evaluate(const LoopLevel& level, const std::vector<glm::vec3>& controlVertices, const std::vector<glm::vec2>& controlUvs) {
+    if (masks.positions.size() != level.vertexCount()) buildLoopLimit(level.indices, level.vertexCount(), level.corners, masks);
+    evaluateLoopLimit(masks, level.indices, level.corners, controlVertices, vertices, normals);
+    if (!controlUvs.empty()) applyStencils(masks.positions, controlUvs, uvs);
+}
+
+void meshObject::LimitSurface::clear() {
+    std::vector<glm::vec3>().swap(vertices);
+    std::vector<glm::vec2>().swap(uvs);
+    std::vector<glm::vec3>().swap(normals);
+}
+
+// Starts moving the level being drawn onto the limit surface, or back, if it
+// does not follow showLimitSurface. Async objects evaluate the limit surface
+// on a worker and stream it in over frames, drawing the level as it was until
+// processPendingUploads swaps the new data in.
+void meshObject::syncLimitSurface() {
+    if (limitJob) {
+        if (limitJob->level == subdivisionLevel && limitJob->project == showLimitSurface) return; // Already on its way
+        if (limitJob->uploading) return; // processPendingUploads comes back once it is swapped in
+        cancelLimitJob();
+    }
+    auto current = smoothLevels.find(subdivisionLevel);
+    if (current == smoothLevels.end() || !current->second.range.valid()) return;
+    SmoothLevel& smooth = current->second;
+    if (showLimitSurface == !smooth.limit.empty()) return;
+
+    std::shared_ptr<LimitJob> job = std::make_shared<LimitJob>();
+    job->level = subdivisionLevel;
+    job->project = showLimitSurface;
+    if (job->project) {
+        job->topology = subdivisionLevels[subdivisionLevel - 1];
+        job->vertices = smooth.vertices;
+        job->uvs = smooth.uvs;
+        job->limit.masks = std::move(smooth.limit.masks); // Built once per level; handed back on swap-in
     }
 
-    // --- Step 1: Create new edge vertices (midpoints) --- 
-    // Reserve space - approximate number of new vertices
-    nextVertices.reserve(originalVertexCount + edgeFaceCount.size()); 
-    nextUvs.reserve(originalVertexCount + edgeFaceCount.size());
-
-    unsigned int currentNewVertexIndex = (unsigned int)originalVertexCount;
-    for (const auto& pair : edgeOppositeVertices) {
-        const Edge& edge = pair.first;
-        const std::vector<unsigned int>& opposites = pair.second;
-
-        unsigned int v0 = edge.v1;
-        unsigned int v1 = edge.v2;
-
-        glm::vec3 newPos;
-        glm::vec2 newUv;
-
-        if (boundaryEdges.count(edge)) { // Boundary edge rule
-            newPos = 0.5f * (smoothVertices[v0] + smoothVertices[v1]);
-            newUv = 0.5f * (smoothUvs[v0] + smoothUvs[v1]);
-        } else { // Interior edge rule
-            if (opposites.size() == 2) { // Should always be 2 for interior edges
-                unsigned int v_opp1 = opposites[0];
-                unsigned int v_opp2 = opposites[1];
-                newPos = (3.0f / 8.0f) * (smoothVertices[v0] + smoothVertices[v1]) +
-                         (1.0f / 8.0f) * (smoothVertices[v_opp1] + smoothVertices[v_opp2]);
-                newUv = (3.0f / 8.0f) * (smoothUvs[v0] + smoothUvs[v1]) +
-                        (1.0f / 8.0f) * (smoothUvs[v_opp1] + smoothUvs[v_opp2]);
-            } else {
-                // Should not happen for a manifold mesh, fallback to boundary rule
-                 std::cerr << "Warning: Interior edge with != 2 opposite vertices found. Edge: (" << v0 << ", " << v1 << ") Opposites: " << opposites.size() << std::endl;
-                 newPos = 0.5f * (smoothVertices[v0] + smoothVertices[v1]);
-                 newUv = 0.5f * (smoothUvs[v0] + smoothUvs[v1]);
-            }
+    limitJob = job;
+    if (loadMode == LoadMode::Async) {
+        projectingObjects.push_back(this);
+        if (job->project) {
+            ThreadPool::shared().submit([job]() { runLimitJob(*job); });
+        } else {
+            runLimitJob(*job); // Nothing to evaluate; only the upload is spread over frames
         }
-        edgeMidpointIndices[edge] = currentNewVertexIndex;
-        nextVertices.push_back(newPos);
-        nextUvs.push_back(newUv);
-        currentNewVertexIndex++;
-    }
-
-    // --- Step 2: Update original vertex positions --- 
-    for (unsigned int i = 0; i < originalVertexCount; ++i) {
-        const std::set<unsigned int>& neighbors = vertexNeighbors[i];
-        int k = (int)neighbors.size();
-
-        if (boundaryVertices.count(i)) { // Boundary vertex rule
-            std::vector<unsigned int> boundaryNeighbors;
-            for (unsigned int neighbor_idx : neighbors) {
-                if (boundaryEdges.count({i, neighbor_idx})) {
-                    boundaryNeighbors.push_back(neighbor_idx);
-                }
-            }
+    } else {
+        runLimitJob(*job);
+        advanceLimitJob(HUGE_VAL);
+    }
+}
 
-            if (boundaryNeighbors.size() == 2) {
-                unsigned int n1 = boundaryNeighbors[0];
-                unsigned int n2 = boundaryNeighbors[1];
-                nextVertices[i] = (1.0f / 8.0f) * smoothVertices[n1] + 
-                                  (6.0f / 8.0f) * smoothVertices[i] + 
-                                  (1.0f / 8.0f) * smoothVertices[n2];
-                nextUvs[i] = (1.0f / 8.0f) * smoothUvs[n1] + 
-                             (6.0f / 8.0f) * smoothUvs[i] + 
-                             (1.0f / 8.0f) * smoothUvs[n2];
-            } else {
-                 // Corner or isolated boundary vertex - keep original position for simplicity
-                 // More complex corner rules exist but are harder to implement robustly.
-                 // std::cerr << "Warning: Boundary vertex " << i << " has " << boundaryNeighbors.size() << " boundary neighbors. Keeping original position." << std::endl;
-                 nextVertices[i] = smoothVertices[i];
-                 nextUvs[i] = smoothUvs[i];
-            }
-        } else { // Interior vertex rule
-            float beta;
-            if (k == 3) {
-                beta = 3.0f / 16.0f;
-            } else { // k > 3 (k < 3 shouldn't happen for interior)
-                beta = (1.0f / k) * (5.0f / 8.0f - pow(3.0f / 8.0f + 0.25f * cos(2.0f * glm::pi<float>() / k), 2.0f));
-            }
+// Evaluates the limit surface over the job's control points. Only touches the job, never the meshObject.
+void meshObject::runLimitJob(LimitJob& job) {
+    if (job.project && !job.cancelled) job.limit.evaluate(*job.topology, job.vertices, job.uvs);
+    job.done = true;
+}
 
-            glm::vec3 neighborPosSum(0.0f);
-            glm::vec2 neighborUvSum(0.0f);
-            for (unsigned int neighbor_idx : neighbors) {
-                neighborPosSum += smoothVertices[neighbor_idx];
-                neighborUvSum += smoothUvs[neighbor_idx];
-            }
+// Stops a limit job that has not started uploading; one that has is swapped in when done.
+void meshObject::cancelLimitJob() {
+    if (!limitJob || limitJob->uploading) return;
+    limitJob->cancelled = true;
+    if (limitJob->done) {
+        // The worker is finished with the masks; the level can keep them
+        auto level = smoothLevels.find(limitJob->level);
+        if (level != smoothLevels.end()) level->second.limit.masks = std::move(limitJob->limit.masks);
+    }
+    limitJob.reset();
+    projectingObjects.erase(std::remove(projectingObjects.begin(), projectingObjects.end(), this), projectingObjects.end());
+}
 
-            nextVertices[i] = (1.0f - k * beta) * smoothVertices[i] + beta * neighborPosSum;
-            nextUvs[i] = (1.0f - k * beta) * smoothUvs[i] + beta * neighborUvSum;
+// Takes over a finished limit job and streams its level into new arena space
+// within the deadline. Once that is complete the level switches over and its
+// old space is freed. Returns true when the job is finished with.
+bool meshObject::advanceLimitJob(double deadline) {
+    LimitJob& job = *limitJob;
+    SmoothLevel& smooth = smoothLevels.at(job.level); // Not evicted while the job runs
+    if (!job.uploading) {
+        if (!job.done) return false;
+        const std::vector<unsigned int>& triangles = levelIndices(job.level);
+        job.range = GeometryArena::shared().allocate(smooth.vertices.size(), triangles.size(), vertexFormat);
+        if (job.project) {
+            queueRangeData(job.range, &job.limit.vertices, &job.limit.uvs, &job.limit.normals, &triangles);
+        } else {
+            queueRangeData(job.range, &smooth.vertices, &smooth.uvs, &smooth.normals, &triangles);
         }
+        job.uploading = true;
     }
 
-    // --- Step 3: Create new faces --- 
-    nextIndices.reserve(smoothIndices.size() * 4); // Each triangle becomes 4
-    for (size_t i = 0; i < smoothIndices.size(); i += 3) {
-        unsigned int v0 = smoothIndices[i];
-        unsigned int v1 = smoothIndices[i + 1];
-        unsigned int v2 = smoothIndices[i + 2];
+    if (!streamUploads(deadline)) return false;
 
-        // Get indices of midpoints (handle potential errors if map lookup fails)
-        unsigned int m01 = edgeMidpointIndices.at({ v0, v1 });
-        unsigned int m12 = edgeMidpointIndices.at({ v1, v2 });
-        unsigned int m20 = edgeMidpointIndices.at({ v2, v0 });
-
-        // Add 4 new triangles (indices refer to nextVertices array)
-        nextIndices.push_back(v0); nextIndices.push_back(m01); nextIndices.push_back(m20);
-        nextIndices.push_back(v1); nextIndices.push_back(m12); nextIndices.push_back(m01);
-        nextIndices.push_back(v2); nextIndices.push_back(m20); nextIndices.push_back(m12);
-        nextIndices.push_back(m01); nextIndices.push_back(m12); nextIndices.push_back(m20);
+    releaseSmoothLevel(smooth);
+    smooth.range = job.range;
+    if (job.project) {
+        smooth.limit = std::move(job.limit);
+    } else {
+        smooth.limit.clear();
     }
+    limitJob.reset();
+    return true;
+}
+
+void meshObject::queueSmoothVertexData(SmoothLevel& smooth) {
+    // Projected levels draw their limit surface instead of the control points
+    bool projected = !smooth.limit.empty();
+    queueRangeData(smooth.range, projected ? &smooth.limit.vertices : &smooth.vertices, projected ? &smooth.limit.uvs : &smooth.uvs,
+                   projected ? &smooth.limit.normals : &smooth.normals, nullptr);
+}
 
-    // Update the mesh data
-    smoothVertices = std::move(nextVertices);
-    smoothUvs = std::move(nextUvs);
-    smoothIndices = std::move(nextIndices);
-    // Normals will be recalculated after all subdivision levels are applied in setSubdivisionLevel
+// Place one level of the smooth (subdivided) mesh in the arena and queue its data
+void meshObject::setupSmoothBuffers(SmoothLevel& smooth, int level) {
+    const std::vector<unsigned int>& smoothIndices = levelIndices(level);
+    smooth.range = GeometryArena::shared().allocate(smooth.vertices.size(), smoothIndices.size(), vertexFormat);
+    queueSmoothVertexData(smooth);
+    queueRangeData(smooth.range, nullptr, nullptr, nullptr, &smoothIndices);
 }
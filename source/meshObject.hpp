@@ -6,40 +6,72 @@
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <common/shader.hpp>
+#include <common/shaderprogram.hpp>
+#include <common/assetregistry.hpp>
+#include <common/renderqueue.hpp>
+#include <common/vertexformat.hpp>
+#include <common/loopsubdivision.hpp>
 #include <map>
 #include <string> // Added for file paths
 #include <vector>  // Added for vertex data storage
-#include <set>     // For edge representation in subdivision
-#include <map>     // For vertex adjacency in subdivision
-
-// Structure to represent an edge (pair of vertex indices)
-struct Edge {
-    unsigned int v1, v2;
-    bool operator<(const Edge& other) const {
-        // Ensure consistent ordering for map/set keys
-        unsigned int min1 = std::min(v1, v2);
-        unsigned int max1 = std::max(v1, v2);
-        unsigned int min2 = std::min(other.v1, other.v2);
-        unsigned int max2 = std::max(other.v1, other.v2);
-        if (min1 != min2) return min1 < min2;
-        return max1 < max2;
-    }
-};
+#include <memory>  // For the shared background load job
+
+// Cached Loop levels, shared with background subdivision jobs
+typedef std::vector<std::shared_ptr<const LoopLevel>> LoopLevels;
 
 class meshObject {
 public:
+    // Blocking loads everything before the constructor returns. Async returns at
+    // once: parsing, texture decoding and subdivision run on worker threads and
+    // the GL uploads are spread over frames by processPendingUploads(). Async
+    // objects also build new subdivision levels in the background, drawing the
+    // current level until the new one is uploaded.
+    enum class LoadMode { Blocking, Async };
+
     meshObject(); // Keep default for now, might remove later
-    meshObject(const std::string& modelPath, const std::string& texturePath); // New constructor
+    meshObject(const std::string& modelPath, const std::string& texturePath, LoadMode mode = LoadMode::Blocking,
+               VertexFormat format = VertexFormat::Separate); // Packed halves the GPU memory of every level
     ~meshObject();
 
-    void draw(const glm::mat4& view, const glm::mat4& projection);
+    bool isReady() const { return loadState == LoadState::Ready; }    // Loaded and uploaded, draws normally
+    bool isLoading() const { return loadState == LoadState::Loading || loadState == LoadState::Uploading; }
+    bool isSubdividing() const { return subdivisionJob != nullptr; } // A new subdivision level is being built or uploaded
+    bool isSimplifying() const { return lodJob != nullptr; } // The LOD chain is being built or uploaded
+    bool isProjecting() const { return limitJob != nullptr; } // A level is being moved onto the limit surface (or back) and uploaded
+
+    // Advances the GL uploads of async objects and swaps in finished subdivision
+    // levels. Call once per frame on the GL thread; stops starting new upload
+    // steps once budgetMs has been spent.
+    static void processPendingUploads(double budgetMs);
+
+    void draw(const glm::mat4& view, const glm::mat4& projection); // Draws right away, resetting the state it changed
+    void submit(RenderQueue& queue, const glm::mat4& view, const glm::mat4& projection); // Queues the same draw, to be submitted in state order
     void drawPicking(const glm::mat4& view, const glm::mat4& projection);
     void translate(const glm::vec3& translation); // Translate the object
     void rotate(float angle, const glm::vec3& axis); // Rotate the object
     void toggleWireframe(); // Method to toggle wireframe
     void toggleSmooth();    // Method to toggle smooth subdivision view
     void toggleTexture();   // Method to toggle texture mapping
+    void toggleLimitSurface(); // Draw smooth levels projected onto the Loop limit surface, with exact limit normals
     void setSubdivisionLevel(int level); // Set the target subdivision level
+    const std::vector<glm::vec3>& getBasePositions() const { return vertices; } // Base vertices in the object's order (reordered for the vertex cache at load)
+    void setBasePositions(const std::vector<glm::vec3>& positions); // Move the base vertices (same count and order as getBasePositions); the smooth mesh follows via cached stencils
+    void setSubdivisionCacheBudget(size_t bytes); // Memory the subdivision pyramid may keep before evicting least recently used levels
+    void setAutoSubdivision(float pixelError, int maxLevel = 4); // Let draw() pick the smooth level from on-screen size, up to maxLevel; pixelError <= 0 turns it off
+    void setLodChain(const std::vector<float>& ratios, float pixelError = 1.0f); // Simplified copies of the base mesh (fractions of its triangles, largest first), drawn instead of it while their error on screen is within pixelError
+
+    // Instances: copies of this mesh, each placed by its own model matrix (the
+    // object's own transform does not apply to them). drawInstances() culls
+    // them against the view, groups them by LOD and draws each group with one
+    // glDrawElementsInstanced. Every instance has a picking ID of its own,
+    // which getMeshObjectById maps back to this object.
+    int addInstance(const glm::mat4& model); // Returns the instance's ID
+    void setInstanceTransform(int instanceId, const glm::mat4& model);
+    void removeInstance(int instanceId);
+    size_t getInstanceCount() const { return instances.size(); }
+    size_t getVisibleInstanceCount() const { return visibleInstances; } // Drawn by the last drawInstances
+    void drawInstances(const glm::mat4& view, const glm::mat4& projection);
+    void drawInstancesPicking(const glm::mat4& view, const glm::mat4& projection); // Base mesh, each instance in the color of its ID
 
     int getId() const { return id; } // Getter for the ID
 
@@ -48,46 +80,198 @@ public:
     // TODO: P1bTask4 - Create a list of children.
 
 private:
-    // OpenGL Buffers and Shaders
-    GLuint VAO, VBO_vertices, VBO_uvs, VBO_normals, EBO;
-    GLuint smoothVAO, smoothVBO_vertices, smoothVBO_uvs, smoothVBO_normals, smoothEBO; // Buffers for subdivided mesh
-    GLuint shaderProgram;
-    GLuint pickingShaderProgram;
-    GLuint textureID; // Texture handle
+    enum class LoadState { Loading, Uploading, Ready, Failed };
+    struct LoadJob; // CPU-side results of a load, filled in on a worker thread
+    struct SubdivisionJob; // A subdivision level being built on a worker thread
+    struct LodJob; // An LOD chain being built on a worker thread
+    struct LimitJob; // A resident level being projected onto the limit surface on a worker thread
+
+    // Data still being streamed into part of an allocated buffer
+    struct BufferUpload {
+        GLuint buffer;
+        const void* data;
+        size_t size;
+        size_t offset; // Bytes uploaded so far
+        size_t destination; // Where in the buffer the data goes
+    };
+
+    // A texture level whose storage is allocated but whose rows are still being streamed in
+    struct TextureUpload {
+        GLuint texture;
+        GLint level;
+        GLsizei width, height;
+        GLenum format;
+        const unsigned char* data;
+        size_t rowBytes;
+        GLsizei rowsDone;
+        bool allocated;
+    };
+
+    // A subdivision level pushed onto the Loop limit surface. UVs go through the
+    // same position masks, so the texture stays where it is on the surface.
+    struct LimitSurface {
+        LoopLimit masks; // Built the first time the level is projected
+        std::vector<glm::vec3> vertices;
+        std::vector<glm::vec2> uvs;
+        std::vector<glm::vec3> normals;
+
+        bool empty() const { return vertices.empty(); }
+        void evaluate(const LoopLevel& level, const std::vector<glm::vec3>& controlVertices, const std::vector<glm::vec2>& controlUvs);
+        void clear(); // Frees the evaluated arrays; the masks are kept for next time
+    };
+
+    // One evaluated subdivision level and its arena space, kept resident until evicted.
+    // Its triangles live in the matching LoopLevel.
+    struct SmoothLevel {
+        std::vector<glm::vec3> vertices; // Control points; higher levels refine these
+        std::vector<glm::vec2> uvs;
+        std::vector<glm::vec3> normals;
+        LimitSurface limit; // Drawn instead of the arrays above while not empty
+        ArenaRange range; // Vertices and triangles in the GeometryArena
+        unsigned long long lastUsed = 0;
+
+        size_t bytes(size_t indexCount, VertexFormat format) const;
+    };
+
+    // A simplified copy of the base mesh. Its triangles index the base
+    // vertices, so it only takes index space in their arena block.
+    struct LodLevel {
+        std::vector<unsigned int> indices;
+        float error = 0.0f; // How far the simplification may be off, in model units
+        ArenaRange range;
+    };
+
+    // OpenGL Buffers and Shaders. Programs, the texture and the base mesh
+    // come from the AssetRegistry and may be shared with other objects. All
+    // mesh data lives in the GeometryArena, so no buffers or VAOs are the
+    // object's own (apart from the instance buffer).
+    std::shared_ptr<GeometryAsset> geometry; // Base mesh
+    std::shared_ptr<ShaderProgram> shaderProgram;
+    std::shared_ptr<ShaderProgram> pickingShaderProgram;
+    int uniformMVP = -1, uniformTextureSampler = -1, uniformUseTexture = -1; // Handles into shaderProgram
+    int pickingUniformMVP = -1, pickingUniformColor = -1; // Handles into pickingShaderProgram
+    std::shared_ptr<TextureAsset> texture;
+    GLuint textureID = 0; // Texture handle (texture's name)
+
+    // Instances
+    struct Instance {
+        glm::mat4 model;
+        int id;
+        int lodLevel; // Drawn last frame, for hysteresis
+        bool visible;
+    };
+    struct InstanceData { // One element of the instance buffer
+        glm::mat4 model;  // Attributes 3-6
+        float pickingId;  // Attribute 7
+    };
+    typedef VertexLayout<FloatAttribute<3, glm::mat4, 4>, FloatAttribute<7, float>> InstanceLayout; // How the shaders read InstanceData
+    std::vector<Instance> instances;
+    std::map<int, size_t> instanceSlots; // Instance ID -> index into instances
+    std::vector<InstanceData> instanceData; // Visible instances of the frame, grouped by LOD
+    GLuint instanceBuffer = 0;
+    size_t instanceBufferBytes = 0; // Allocated size
+    size_t visibleInstances = 0;
+    std::shared_ptr<ShaderProgram> instancedShaderProgram;
+    std::shared_ptr<ShaderProgram> pickingInstancedShaderProgram;
+    int instancedUniformVP = -1, instancedUniformTextureSampler = -1, instancedUniformUseTexture = -1; // Handles into instancedShaderProgram
+    int pickingInstancedUniformVP = -1; // Handle into pickingInstancedShaderProgram
+
+    // Loading State
+    LoadState loadState = LoadState::Ready;
+    std::shared_ptr<LoadJob> loadJob; // Shared with the worker until the CPU work is done
+    int uploadStage = 0;
+    std::vector<BufferUpload> bufferUploads;
+    std::vector<TextureUpload> textureUploads;
+    int pendingSubdivisionLevel = -1; // Level requested while still loading
+    LoadMode loadMode = LoadMode::Blocking; // Async objects also subdivide in the background
+    VertexFormat vertexFormat = VertexFormat::Separate; // Of every level this object uploads
+    PositionQuantization quantization; // Box of the base mesh; subdivision stays inside it, so all levels are packed against it
+    std::vector<std::vector<unsigned char>> packedStaging; // Packed copies of queued vertex data, kept until uploaded
+    std::shared_ptr<SubdivisionJob> subdivisionJob; // Level being built or uploaded, if any
+    int requestedSubdivisionLevel = 0; // Level the object is heading for; subdivisionLevel is the one drawn
+    std::shared_ptr<LodJob> lodJob; // LOD chain being built or uploaded, if any
+    std::shared_ptr<LimitJob> limitJob; // Resident level being projected (or unprojected) or uploaded, if any
 
     // Object State
     glm::mat4 modelMatrix;
     bool showWireframe = false; // Wireframe toggle state
     bool showSmooth = false;    // Smooth subdivision toggle state
     bool showTexture = true;    // Texture toggle state
+    bool showLimitSurface = false; // Limit surface toggle state
     int subdivisionLevel = 0;   // Current subdivision level applied
     int targetSubdivisionLevel = 2; // Target level for smooth toggle
+    float autoSubdivisionPixelError = 0.0f; // Screen-space error the automatic level stays within (0 = off)
+    int autoSubdivisionMaxLevel = 4;
 
     // Mesh Data (Loaded from OBJ)
     std::vector<glm::vec3> vertices;
     std::vector<glm::vec2> uvs;
     std::vector<glm::vec3> normals;
     std::vector<unsigned int> indices;
-    GLsizei numIndices; // Renamed from indices.size() usage
+    GLsizei numIndices = 0; // Renamed from indices.size() usage
 
     // Subdivided Mesh Data
-    std::vector<glm::vec3> smoothVertices;
-    std::vector<glm::vec2> smoothUvs;
-    std::vector<glm::vec3> smoothNormals;
-    std::vector<unsigned int> smoothIndices;
-    GLsizei numSmoothIndices = 0;
+    LoopLevels subdivisionLevels; // Cached stencils and faces for each level built so far
+    VertexCorners baseCorners; // Vertex -> face table of the base mesh, for recomputing its normals
+    glm::vec3 boundingCenter = glm::vec3(0.0f); // Bounding sphere of the base mesh, in model space
+    float boundingRadius = 0.0f;
+    float limitError = 0.0f; // Largest distance from a base vertex to the limit surface
+    std::map<int, SmoothLevel> smoothLevels;  // Subdivision pyramid: every resident level above 0
+    size_t smoothCacheBudget = size_t(256) << 20; // Bytes the pyramid may hold
+    unsigned long long smoothUseCounter = 0;  // Clock for least-recently-used eviction
+
+    // Simplified Mesh Data
+    std::vector<LodLevel> lodLevels; // Coarser and coarser copies of the base mesh
+    std::vector<float> lodRatios; // Requested chain, also kept for a load that has not finished
+    float lodPixelError = 1.0f;
+    int lodLevel = 0; // Drawn in place of the base mesh: 0 is the base mesh itself, n is lodLevels[n - 1]
 
     // Static members for ID management and lookup
     static int nextId; // Static counter for unique IDs
     int id;            // ID for this specific object
     static std::map<int, meshObject*> meshObjectMap; // Static map of ID to Object
+    static std::vector<meshObject*> loadingObjects;  // Async objects not yet ready (GL thread only)
+    static std::vector<meshObject*> subdividingObjects; // Objects with a subdivision job in flight (GL thread only)
+    static std::vector<meshObject*> simplifyingObjects; // Objects with an LOD job in flight (GL thread only)
+    static std::vector<meshObject*> projectingObjects; // Objects with a limit job in flight (GL thread only)
 
     // Private helper methods
-    GLuint loadTexture(const std::string& path); // Texture loading function
-    void setupBuffers(); // Helper to setup OpenGL buffers
-    void setupSmoothBuffers(); // Helper to setup buffers for the smooth mesh
-    void applyLoopSubdivision(); // Performs one level of Loop subdivision
-    void calculateNormals(std::vector<glm::vec3>& verts, const std::vector<unsigned int>& inds, std::vector<glm::vec3>& norms); // Calculates vertex normals
+    std::vector<size_t> gatherInstances(const glm::mat4& view, const glm::mat4& projection, int levels); // Culls, picks LODs and uploads the instance buffer; returns where each LOD's instances start (plus the end)
+    void bindInstanceAttributes(size_t firstInstance, bool enable); // Points attributes 3-7 of the bound VAO at the instance buffer, or disables them
+    bool prepareDraw(const glm::mat4& view, const glm::mat4& projection, DrawItem& item); // What draw() and submit() draw; false if nothing
+    glm::mat4 positionDecode() const; // Maps stored positions to model space (identity unless packed)
+    static void runLoadJob(LoadJob& job); // CPU part of loading, safe to run on any thread
+    bool advanceLoad(double deadline); // Runs GL upload steps until done or past the deadline
+    bool setupTexture(LoadJob& job, GLuint textureName); // Fills the GL texture's parameters and queues its mip levels
+    bool acquireTexture(LoadJob& job); // Shares a registered texture or creates one; false to wait for one still uploading
+    bool acquireGeometry(LoadJob& job); // Same for the base mesh
+    void setupBuffers(); // Queues the base mesh for upload, unless it is shared and uploaded
+    void detachGeometry(); // Moves the base mesh into arena space of its own before it is edited
+    bool placeLodLevels(std::vector<LodLevel>& levels); // Takes index space for LODs next to the base vertices and queues them; drops those that do not fit
+    void releaseLodRanges(std::vector<LodLevel>& levels);
+    void setupSmoothBuffers(SmoothLevel& smooth, int level); // Takes arena space for one smooth level and queues its data
+    static void runSubdivisionJob(SubdivisionJob& job); // CPU part of building a level, safe to run on any thread
+    void startSubdivisionJob(int level); // Builds a non-resident level, in the background for async objects
+    void cancelSubdivisionJob(); // Drops a job that has not been swapped in yet
+    bool advanceSubdivision(double deadline); // Uploads a finished job and swaps it in
+    void evictSmoothLevels(int keepLevel); // Enforces the pyramid's memory budget
+    void releaseSmoothLevel(SmoothLevel& smooth); // Frees a level's arena space
+    void syncLimitSurface(); // Starts projecting the drawn level or dropping its projection, following showLimitSurface
+    static void runLimitJob(LimitJob& job); // CPU part of projecting a level, safe to run on any thread
+    void cancelLimitJob(); // Drops a limit job that is not uploading yet
+    bool advanceLimitJob(double deadline); // Uploads a finished limit job into new arena space and swaps it in
+    void queueSmoothVertexData(SmoothLevel& smooth); // Queues the arrays a level draws (projected or not) for upload
+    const std::vector<unsigned int>& levelIndices(int level) const; // Triangles of a level (0 is the base mesh)
+    float pixelsPerUnit(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, float viewportHeight) const; // Screen pixels per model unit at the nearest point of the bounding sphere
+    int pickSubdivisionLevel(const glm::mat4& view, const glm::mat4& projection) const; // Level whose error on screen is within autoSubdivisionPixelError
+    int pickLodLevel(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, float viewportHeight, int current) const; // Coarsest LOD whose error on screen is within lodPixelError
+    static void runLodJob(LodJob& job); // CPU part of building the LOD chain, safe to run on any thread
+    void startLodJob(); // Builds lodRatios, in the background for async objects
+    bool advanceLodChain(double deadline); // Uploads a finished LOD chain and swaps it in
+    void releaseLodLevels(); // Frees the LODs' arena space and drops them
+    void queueBufferSubData(GLuint buffer, size_t destination, const void* data, size_t size); // Queues an upload into part of a buffer
+    void queueRangeData(const ArenaRange& range, const std::vector<glm::vec3>* positions, const std::vector<glm::vec2>* uvs, const std::vector<glm::vec3>* normals, const std::vector<unsigned int>* triangles); // Queues the given arrays (null for none) into an arena range
+    bool streamUploads(double deadline); // Uploads queued texture and buffer data in slices
 };
 
 #endif
@@ -0,0 +1,9 @@
+#version 330 core
+
+flat in vec4 pickingColor; // Per instance, from the vertex shader
+
+out vec4 color;
+
+void main() {
+    color = pickingColor;
+}
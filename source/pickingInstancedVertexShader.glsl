@@ -0,0 +1,21 @@
+#version 330 core
+
+// Input vertex attributes (from VBO)
+layout(location = 0) in vec3 position; // Vertex position
+
+// Per-instance attributes (from the instance buffer, one value per instance)
+layout(location = 3) in mat4 instanceModel; // Model matrix, locations 3-6
+layout(location = 7) in float instanceID;   // Picking ID (exact up to 2^24)
+
+// Picking color, the ID's low three bytes in red, green and blue
+flat out vec4 pickingColor;
+
+// Uniforms
+uniform mat4 VP; // Combined View-Projection matrix
+
+void main() {
+    gl_Position = VP * (instanceModel * vec4(position, 1.0));
+
+    int id = int(instanceID);
+    pickingColor = vec4(float(id & 0xFF), float((id >> 8) & 0xFF), float((id >> 16) & 0xFF), 255.0) / 255.0;
+}
@@ -0,0 +1,178 @@
+// Checks simplifyMeshChain on a generated sheet with a UV seam and on the head
+// mesh: errors grow along the chain, every target is either reached or its
+// level repeats the last one reached (and is dropped by the LOD chain), and
+// boundary and seam vertices and edges survive every level untouched.
+//
+//   simplifytest [file.obj]
+//
+// Exits with 1 if any check fails.
+
+#include <stdio.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "common/objloader.hpp"
+#include "common/meshsimplify.hpp"
+
+namespace {
+
+const char *defaultPath = "source/low_poly_head.obj";
+
+int failures = 0;
+
+#define CHECK(condition, ...)                               \
+    do {                                                    \
+        if (!(condition)) {                                 \
+            printf("  FAILED %s: ", #condition);            \
+            printf(__VA_ARGS__);                            \
+            printf("\n");                                   \
+            failures++;                                     \
+        }                                                   \
+    } while (0)
+
+typedef std::pair<unsigned int, unsigned int> Edge;
+
+// Undirected edges used by exactly one triangle
+std::set<Edge> boundaryEdges(const std::vector<unsigned int> &indices) {
+    std::map<Edge, int> uses;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (int k = 0; k < 3; k++) {
+            unsigned int a = indices[i + k], b = indices[i + (k + 1) % 3];
+            uses[Edge(std::min(a, b), std::max(a, b))]++;
+        }
+    }
+    std::set<Edge> result;
+    for (const auto &use : uses) {
+        if (use.second == 1)
+            result.insert(use.first);
+    }
+    return result;
+}
+
+// Vertices whose position is shared with another vertex
+std::set<unsigned int> seamVertices(const std::vector<glm::vec3> &positions) {
+    std::map<std::vector<float>, std::vector<unsigned int>> byPosition;
+    for (size_t v = 0; v < positions.size(); v++)
+        byPosition[{ positions[v].x, positions[v].y, positions[v].z }].push_back(static_cast<unsigned int>(v));
+    std::set<unsigned int> result;
+    for (const auto &group : byPosition) {
+        if (group.second.size() > 1)
+            result.insert(group.second.begin(), group.second.end());
+    }
+    return result;
+}
+
+// A curved, open sheet of size x size vertices, split along the middle
+// column: both halves have their own copy of it, as a UV seam would give.
+void makeSeamedSheet(unsigned int size, std::vector<glm::vec3> &positions, std::vector<unsigned int> &indices) {
+    const unsigned int seam = size / 2;
+    std::vector<unsigned int> left(size * size), right(size * size);
+    for (unsigned int y = 0; y < size; y++) {
+        for (unsigned int x = 0; x < size; x++) {
+            float u = float(x) / (size - 1), v = float(y) / (size - 1);
+            glm::vec3 p(u, v, 0.2f * std::sin(3.0f * u) * std::cos(2.0f * v));
+            if (x <= seam) {
+                left[y * size + x] = static_cast<unsigned int>(positions.size());
+                positions.push_back(p);
+            }
+            if (x >= seam) {
+                right[y * size + x] = static_cast<unsigned int>(positions.size());
+                positions.push_back(p);
+            }
+        }
+    }
+    for (unsigned int y = 0; y + 1 < size; y++) {
+        for (unsigned int x = 0; x + 1 < size; x++) {
+            const std::vector<unsigned int> &side = (x < seam) ? left : right;
+            unsigned int a = side[y * size + x], b = side[y * size + x + 1];
+            unsigned int c = side[(y + 1) * size + x], d = side[(y + 1) * size + x + 1];
+            unsigned int quad[6] = { a, b, d, a, d, c };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+}
+
+void checkChain(const char *name, const std::vector<glm::vec3> &positions, const std::vector<unsigned int> &indices) {
+    const size_t triangles = indices.size() / 3;
+    // Halving down to a few triangles; the last targets cannot be reached
+    // while the boundary and seams are locked
+    std::vector<size_t> targets = { triangles / 2, triangles / 4, triangles / 8, 2, 1 };
+    std::vector<std::vector<unsigned int>> chain;
+    std::vector<float> errors;
+    simplifyMeshChain(positions, indices, targets, chain, errors);
+
+    printf("%s: %zu triangles ->", name, triangles);
+    for (size_t i = 0; i < chain.size(); i++)
+        printf(" %zu (error %g)", chain[i].size() / 3, errors[i]);
+    printf("\n");
+
+    CHECK(chain.size() == targets.size() && errors.size() == targets.size(), "%zu levels, %zu errors", chain.size(), errors.size());
+    if (chain.size() != targets.size() || errors.size() != targets.size())
+        return;
+    CHECK(chain[0].size() / 3 <= targets[0], "the first target (%zu) should be reachable, got %zu", targets[0], chain[0].size() / 3);
+
+    const std::set<Edge> boundary = boundaryEdges(indices);
+    std::set<unsigned int> kept = seamVertices(positions);
+    for (const Edge &edge : boundary) {
+        kept.insert(edge.first);
+        kept.insert(edge.second);
+    }
+    CHECK(!kept.empty(), "the mesh should have boundary or seam vertices");
+
+    for (size_t i = 0; i < chain.size(); i++) {
+        const std::vector<unsigned int> &level = chain[i];
+        CHECK(level.size() % 3 == 0, "level %zu has %zu indices", i, level.size());
+        CHECK(std::isfinite(errors[i]) && errors[i] >= 0.0f, "level %zu error %g", i, errors[i]);
+        if (i > 0) {
+            CHECK(errors[i] >= errors[i - 1], "error fell from %g to %g at level %zu", errors[i - 1], errors[i], i);
+            CHECK(level.size() <= chain[i - 1].size(), "level %zu grew from %zu to %zu triangles", i, chain[i - 1].size() / 3, level.size() / 3);
+        }
+
+        // Reached, or nothing more could be collapsed: every later level is
+        // then the same mesh, which the LOD chain drops
+        if (level.size() / 3 > targets[i]) {
+            for (size_t j = i + 1; j < chain.size(); j++)
+                CHECK(chain[j] == level, "target %zu missed at level %zu, but level %zu still changed", targets[i], i, j);
+        }
+
+        std::set<unsigned int> used;
+        for (size_t k = 0; k < level.size(); k += 3) {
+            CHECK(level[k] != level[k + 1] && level[k + 1] != level[k + 2] && level[k + 2] != level[k],
+                  "level %zu has a degenerate triangle", i);
+            used.insert(&level[k], &level[k] + 3);
+        }
+        CHECK(*used.rbegin() < positions.size(), "level %zu indexes past the vertices", i);
+        for (unsigned int v : kept)
+            CHECK(used.count(v) == 1, "boundary or seam vertex %u removed at level %zu", v, i);
+        CHECK(boundaryEdges(level) == boundary, "level %zu changed the boundary edges", i);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::vector<glm::vec3> sheetPositions;
+    std::vector<unsigned int> sheetIndices;
+    makeSeamedSheet(48, sheetPositions, sheetIndices);
+    checkChain("seamed sheet", sheetPositions, sheetIndices);
+
+    const char *path = argc > 1 ? argv[1] : defaultPath;
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<unsigned int> indices;
+    CHECK(loadOBJ(path, positions, uvs, normals, indices), "could not load %s", path);
+    if (!indices.empty())
+        checkChain(path, positions, indices);
+
+    if (failures == 0)
+        printf("All checks passed\n");
+    else
+        printf("%d checks failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+// Checks the indexed computeTangentBasis against the triangle soup version
+// followed by indexVBO_TBN, on generated tori (one with its UVs mirrored, so
+// every vertex is left-handed) and on the head mesh at its base and first
+// Loop level:
+//
+//   - tangents are unit length and orthogonal to the normals, w is +1 or -1
+//   - w agrees with the welded bitangents of the soup path
+//   - where the UVs are smooth (the tori), w * tangent points the same way
+//     as the welded soup tangent
+//
+//   tangenttest [file.obj]
+//
+// Exits with 1 if any check fails.
+
+#include <stdio.h>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "common/objloader.hpp"
+#include "common/tangentspace.hpp"
+#include "common/vboindexer.hpp"
+#include "common/loopsubdivision.hpp"
+#include "common/vertexnormals.hpp"
+
+namespace {
+
+const char *defaultPath = "source/low_poly_head.obj";
+const float pi = 3.14159265358979f;
+
+int failures = 0;
+
+#define CHECK(condition, ...)                               \
+    do {                                                    \
+        if (!(condition)) {                                 \
+            printf("  FAILED %s: ", #condition);            \
+            printf(__VA_ARGS__);                            \
+            printf("\n");                                   \
+            failures++;                                     \
+        }                                                   \
+    } while (0)
+
+struct Mesh {
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<unsigned int> indices;
+};
+
+// A torus with UVs following its two angles (u mirrored if asked), and a seam
+// of duplicated vertices where they wrap around
+Mesh makeTorus(unsigned int rings, unsigned int sides, bool mirrored) {
+    Mesh mesh;
+    for (unsigned int i = 0; i <= rings; i++) {
+        for (unsigned int j = 0; j <= sides; j++) {
+            float u = float(i) / rings, v = float(j) / sides;
+            float a = 2.0f * pi * u, b = 2.0f * pi * v;
+            glm::vec3 around(std::cos(a), std::sin(a), 0.0f);
+            glm::vec3 normal = std::cos(b) * around + glm::vec3(0.0f, 0.0f, std::sin(b));
+            mesh.positions.push_back(2.0f * around + 0.5f * normal);
+            mesh.normals.push_back(normal);
+            mesh.uvs.push_back(glm::vec2(mirrored ? 1.0f - u : u, v));
+        }
+    }
+    for (unsigned int i = 0; i < rings; i++) {
+        for (unsigned int j = 0; j < sides; j++) {
+            unsigned int a = i * (sides + 1) + j, b = a + 1, c = a + sides + 1, d = c + 1;
+            unsigned int quad[6] = { a, c, d, a, d, b };
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    return mesh;
+}
+
+// The way tangents were made before: de-index, one tangent per corner, weld
+void soupTangents(const Mesh &mesh, std::vector<unsigned int> &welded, std::vector<glm::vec3> &tangents,
+                  std::vector<glm::vec3> &bitangents) {
+    std::vector<glm::vec3> positions, normals, cornerTangents, cornerBitangents;
+    std::vector<glm::vec2> uvs;
+    for (unsigned int index : mesh.indices) {
+        positions.push_back(mesh.positions[index]);
+        uvs.push_back(mesh.uvs[index]);
+        normals.push_back(mesh.normals[index]);
+    }
+    computeTangentBasis(positions, uvs, normals, cornerTangents, cornerBitangents);
+
+    // Only exact copies of a vertex are merged, so the welded mesh keeps the indexed one's vertices
+    std::vector<glm::vec3> outPositions, outNormals;
+    std::vector<glm::vec2> outUvs;
+    indexVBO_TBN(positions, uvs, normals, cornerTangents, cornerBitangents,
+                 welded, outPositions, outUvs, outNormals, tangents, bitangents, 1e-6f);
+}
+
+// 'directions' also compares the tangent directions, which only agree where
+// the faces around a vertex have similar tangents: the soup path normalizes
+// each face's tangent before summing, the indexed path does not. 'corners'
+// is a prebuilt vertex-corner table, if any.
+void checkTangents(const char *name, const Mesh &mesh, bool directions, const VertexCorners *corners = nullptr) {
+    std::vector<glm::vec4> tangents;
+    if (corners)
+        computeTangentBasis(mesh.positions, mesh.uvs, mesh.normals, mesh.indices, *corners, tangents);
+    else
+        computeTangentBasis(mesh.positions, mesh.uvs, mesh.normals, mesh.indices, tangents);
+
+    std::vector<unsigned int> welded;
+    std::vector<glm::vec3> soupT, soupB;
+    soupTangents(mesh, welded, soupT, soupB);
+
+    printf("%s: %zu vertices, %zu welded\n", name, mesh.positions.size(), soupT.size());
+    CHECK(tangents.size() == mesh.positions.size(), "%zu tangents for %zu vertices", tangents.size(), mesh.positions.size());
+    CHECK(welded.size() == mesh.indices.size(), "%zu welded indices for %zu", welded.size(), mesh.indices.size());
+    if (tangents.size() != mesh.positions.size() || welded.size() != mesh.indices.size())
+        return;
+
+    for (size_t v = 0; v < tangents.size(); v++) {
+        glm::vec3 t(tangents[v]);
+        const glm::vec3 &n = mesh.normals[v];
+        CHECK(std::fabs(glm::length(t) - 1.0f) < 1e-4f, "vertex %zu tangent length %g", v, glm::length(t));
+        CHECK(std::fabs(glm::dot(t, n)) < 1e-4f, "vertex %zu tangent not orthogonal to its normal (%g)", v, glm::dot(t, n));
+        CHECK(tangents[v].w == 1.0f || tangents[v].w == -1.0f, "vertex %zu handedness %g", v, tangents[v].w);
+    }
+
+    // Every corner maps one indexed vertex to one welded vertex
+    size_t handedness = 0, direction = 0, compared = 0;
+    std::vector<bool> seen(tangents.size(), false);
+    for (size_t i = 0; i < mesh.indices.size(); i++) {
+        unsigned int v = mesh.indices[i], w = welded[i];
+        if (seen[v])
+            continue;
+        seen[v] = true;
+
+        glm::vec3 t(tangents[v]);
+        const glm::vec3 &n = mesh.normals[v];
+        float sign = glm::dot(glm::cross(n, t), soupB[w]);
+        if (std::fabs(sign) < 1e-6f * glm::length(soupB[w]))
+            continue; // The welded bitangent lies along the tangent; no handedness to compare
+        compared++;
+        if ((sign < 0.0f ? -1.0f : 1.0f) != tangents[v].w)
+            handedness++;
+
+        // The soup path flips its tangent instead of storing w
+        glm::vec3 soup = soupT[w] - n * glm::dot(n, soupT[w]);
+        if (directions && glm::dot(glm::normalize(soup), tangents[v].w * t) < 0.999f)
+            direction++;
+    }
+    CHECK(compared > 0, "no vertex could be compared");
+    CHECK(handedness == 0, "%zu of %zu vertices have the other handedness", handedness, compared);
+    if (directions)
+        CHECK(direction == 0, "%zu of %zu tangents point elsewhere", direction, compared);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    checkTangents("torus", makeTorus(48, 24, false), true);
+    checkTangents("mirrored torus", makeTorus(48, 24, true), true);
+
+    const char *path = argc > 1 ? argv[1] : defaultPath;
+    Mesh head;
+    std::vector<glm::vec3> normals;
+    CHECK(loadOBJ(path, head.positions, head.uvs, normals, head.indices), "could not load %s", path);
+    if (!head.indices.empty()) {
+        computeVertexNormals(head.positions, head.indices, head.normals);
+        checkTangents(path, head, false);
+
+        // The first subdivision level, with its topology's own corner table
+        LoopLevel level;
+        buildLoopLevel(head.indices, head.positions.size(), level);
+        Mesh smooth;
+        applyStencils(level.stencils, head.positions, smooth.positions);
+        applyStencils(level.stencils, head.uvs, smooth.uvs);
+        smooth.indices = level.indices;
+        computeVertexNormals(smooth.positions, smooth.indices, level.corners, smooth.normals);
+        checkTangents("level 1", smooth, false, &level.corners);
+    }
+
+    if (failures == 0)
+        printf("All checks passed\n");
+    else
+        printf("%d checks failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}